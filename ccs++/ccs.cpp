@@ -1,30 +1,133 @@
 #include "ccs.h"
 #include "ccsvisitor.h"
+#include "ccscache.h"
+#include "ccsnormal.h"
 #include <sstream>
+#include <mutex>
+#include <unordered_map>
 
 using namespace std;
 using namespace ccspp;
 
-CCSAction::CCSAction(Type type, string name, shared_ptr<CCSExp> param, string input, shared_ptr<CCSExp> exp)
-    :type(type), name(name), param(param), input(input), exp(exp)
+//the table is never destroyed, actions may outlive static destruction
+static vector<const string*>& symbolNames()
+{
+    static vector<const string*>* names = new vector<const string*>{ new string() };
+    return *names;
+}
+
+static unordered_map<string, uint32_t>& symbolIds()
+{
+    static unordered_map<string, uint32_t>* ids = new unordered_map<string, uint32_t>{ { "", 0 } };
+    return *ids;
+}
+
+//names are interned during transition inference, which may run on several threads
+static mutex& symbolLock()
+{
+    static mutex* lock = new mutex();
+    return *lock;
+}
+
+uint32_t CCSSymbols::intern(const string& name)
+{
+    lock_guard<mutex> lock(symbolLock());
+    unordered_map<string, uint32_t>& ids = symbolIds();
+    auto it = ids.find(name);
+    if(it != ids.end())
+        return it->second;
+    uint32_t id = symbolNames().size();
+    it = ids.emplace(name, id).first;
+    symbolNames().push_back(&it->first);
+    return id;
+}
+
+const string& CCSSymbols::name(uint32_t id)
+{
+    //the strings themselves never move, only the vector of pointers to them,
+    //so every thread keeps a copy of the pointers and only locks the table for ids it has not seen yet
+    static thread_local vector<const string*> names;
+    if(id >= names.size())
+    {
+        lock_guard<mutex> lock(symbolLock());
+        const vector<const string*>& all = symbolNames();
+        names.insert(names.end(), all.begin() + names.size(), all.end());
+    }
+    return *names.at(id);
+}
+
+static int compareNames(uint32_t id1, uint32_t id2)
+{
+    if(id1 == id2)
+        return 0;
+    int c = CCSSymbols::name(id1).compare(CCSSymbols::name(id2));
+    return c < 0 ? -1 : c > 0 ? 1 : 0;
+}
+
+
+
+CCSEnv::CCSEnv()
+    :mask(0)
+{}
+
+CCSEnv::CCSEnv(vector<uint32_t> ids, vector<int> vals)
+    :ids(move(ids)), vals(move(vals)), mask(0)
+{
+    for(uint32_t id : this->ids)
+        mask |= idMask(id);
+}
+
+bool CCSEnv::empty() const
+{ return ids.empty(); }
+
+uint64_t CCSEnv::getMask() const
+{ return mask; }
+
+const int* CCSEnv::find(uint32_t id) const
+{
+    if(!(mask & idMask(id)))
+        return nullptr;
+    for(size_t i = ids.size(); i-- > 0;)
+        if(ids[i] == id)
+            return &vals[i];
+    return nullptr;
+}
+
+CCSEnv CCSEnv::without(uint32_t id) const
+{
+    vector<uint32_t> ids2;
+    vector<int> vals2;
+    for(size_t i = 0; i < ids.size(); i++)
+        if(ids[i] != id)
+        {
+            ids2.push_back(ids[i]);
+            vals2.push_back(vals[i]);
+        }
+    return CCSEnv(move(ids2), move(vals2));
+}
+
+
+
+CCSAction::CCSAction(Type type, uint32_t name, CCSRef<CCSExp> param, uint32_t input, CCSRef<CCSExp> exp)
+    :type(type), name(name), input(input), param(param), exp(exp)
 {}
 
 CCSAction::CCSAction(Type type)
-    :type(type)
+    :type(type), name(0), input(0)
 {
     if(type != NONE && type != TAU && type != DELTA)
         throw CCSException("invalid action type without name");
 }
 
-CCSAction::CCSAction(Type type, string name, shared_ptr<CCSExp> param)
-    :type(type), name(name), param(param)
+CCSAction::CCSAction(Type type, string name, CCSRef<CCSExp> param)
+    :type(type), name(CCSSymbols::intern(name)), input(0), param(param)
 {
     if(type != NONE && type != SEND && type != RECV && (name != "" || param != nullptr))
         throw CCSException("invalid action type with name");
 }
 
-CCSAction::CCSAction(Type type, string name, shared_ptr<CCSExp> param, string input)
-    :type(type), name(name), param(param), input(input)
+CCSAction::CCSAction(Type type, string name, CCSRef<CCSExp> param, string input)
+    :type(type), name(CCSSymbols::intern(name)), input(CCSSymbols::intern(input)), param(param)
 {
     if(type != RECV)
         throw CCSException("invalid action type with input");
@@ -32,8 +135,8 @@ CCSAction::CCSAction(Type type, string name, shared_ptr<CCSExp> param, string in
         throw CCSException("invalid action type without name");
 }
 
-CCSAction::CCSAction(Type type, string name, shared_ptr<CCSExp> param, shared_ptr<CCSExp> exp)
-    :type(type), name(name), param(param), exp(exp)
+CCSAction::CCSAction(Type type, string name, CCSRef<CCSExp> param, CCSRef<CCSExp> exp)
+    :type(type), name(CCSSymbols::intern(name)), input(0), param(param), exp(exp)
 {
     if(type != SEND && type != RECV)
         throw CCSException("invalid action type with expression");
@@ -42,54 +145,76 @@ CCSAction::CCSAction(Type type, string name, shared_ptr<CCSExp> param, shared_pt
 }
 
 string CCSAction::getName() const
+{ return CCSSymbols::name(name); }
+
+uint32_t CCSAction::getNameId() const
 { return name; }
 
 CCSAction::Type CCSAction::getType() const
 { return type; }
 
-shared_ptr<CCSExp> CCSAction::getParam() const
+CCSRef<CCSExp> CCSAction::getParam() const
 { return param; }
 
 string CCSAction::getInput() const
+{ return CCSSymbols::name(input); }
+
+uint32_t CCSAction::getInputId() const
 { return input; }
 
-shared_ptr<CCSExp> CCSAction::getExp() const
+CCSRef<CCSExp> CCSAction::getExp() const
 { return exp; }
 
 CCSAction CCSAction::getBase() const
-{ return CCSAction(type, name, param); }
+{ return CCSAction(type, name, param, 0, nullptr); }
 
 CCSAction CCSAction::getPlain() const
-{ return CCSAction(type, name); }
+{ return CCSAction(type, name, nullptr, 0, nullptr); }
 
 CCSAction CCSAction::getNone() const
-{ return CCSAction(NONE, name); }
+{ return CCSAction(NONE, name, nullptr, 0, nullptr); }
+
+bool CCSAction::isComplement(const CCSAction& act) const
+{
+    return ((type == SEND && act.type == RECV) || (type == RECV && act.type == SEND)) &&
+        name == act.name &&
+        (param == act.param || (param != nullptr && act.param != nullptr && param->compare(*act.param) == 0));
+}
 
 CCSAction CCSAction::subst(string id, int v, bool fold) const
+{ return subst(CCSEnv({ CCSSymbols::intern(id) }, { v }), fold); }
+
+CCSAction CCSAction::subst(const CCSEnv& env, bool fold) const
 {
-    shared_ptr<CCSExp> param2;
-    shared_ptr<CCSExp> exp2;
+    CCSRef<CCSExp> param2;
+    CCSRef<CCSExp> exp2;
     if(param != nullptr)
-        param2 = param->subst(id, v, fold);
+        param2 = param->subst(env, fold);
     if(exp != nullptr)
-        exp2 = exp->subst(id, v, fold);
+        exp2 = exp->subst(env, fold);
     return CCSAction(type, name, param2, input, exp2);
 }
 
+uint64_t CCSAction::getVars() const
+{ return (param ? param->getVars() : 0) | (exp ? exp->getVars() : 0); }
+
+bool CCSAction::isFoldable() const
+{ return (param && param->isFoldable()) || (exp && exp->isFoldable()); }
+
 CCSAction CCSAction::eval() const
 {
-    shared_ptr<CCSExp> param2;
-    shared_ptr<CCSExp> exp2;
+    CCSRef<CCSExp> param2;
+    CCSRef<CCSExp> exp2;
     if(param != nullptr)
         if(param->getType() == CCSExp::CONST)
             param2 = param;
         else
-            param2 = make_shared<CCSConstExp>(param->eval());
+            param2 = make_exp<CCSConstExp>(param->eval());
     if(exp != nullptr)
         if(exp->getType() == CCSExp::CONST)
             exp2 = exp;
         else
-            exp2 = make_shared<CCSConstExp>(exp->eval());
+            exp2 = make_exp<CCSConstExp>(exp->eval());
     return CCSAction(type, name, param2, input, exp2);
 }
 
@@ -104,7 +229,7 @@ void CCSAction::print(ostream& out) const
         out << "e";
         break;
     case SEND:
-        out << name;
+        out << CCSSymbols::name(name);
         if(param != nullptr)
         {
             out << "(";
@@ -116,7 +241,7 @@ void CCSAction::print(ostream& out) const
             exp->print(out);
         break;
     case RECV:
-        out << name;
+        out << CCSSymbols::name(name);
         if(param != nullptr)
         {
             out << "(";
@@ -124,13 +249,13 @@ void CCSAction::print(ostream& out) const
             out << ")";
         }
         out << "?";
-        if(input != "")
-            out << input;
+        if(input != 0)
+            out << CCSSymbols::name(input);
         if(exp != nullptr)
             exp->print(out);
         break;
     case NONE:
-        out << name;
+        out << CCSSymbols::name(name);
         break;
     }
 }
@@ -158,37 +283,43 @@ CCSAction CCSAction::operator~ () const
     return CCSAction(t2, name, param, input, exp);
 }
 
+uint64_t CCSAction::getHash() const
+{
+    uint64_t h = hash_combine(type, ((uint64_t)name << 32) | input);
+    if(param != nullptr)
+        h = hash_combine(h, param->getHash());
+    if(exp != nullptr)
+        h = hash_combine(h, exp->getHash());
+    return h;
+}
+
 int CCSAction::compare(const CCSAction& act) const
 {
-    if(type < act.type)
-        return -1;
-    else if(type > act.type)
-        return 1;
-    if(name < act.name)
-        return -1;
-    else if(name > act.name)
-        return 1;
+    if(type != act.type)
+        return type < act.type ? -1 : 1;
+    int c = compareNames(name, act.name);
+    if(c != 0)
+        return c;
     if(param != act.param)
     {
         if(param == nullptr)
             return -1;
         else if(act.param == nullptr)
             return 1;
-        int c = param->compare(*act.param);
+        c = param->compare(*act.param);
         if(c != 0)
             return c;
     }
-    if(input < act.input)
-        return -1;
-    else if(input > act.input)
-        return 1;
+    c = compareNames(input, act.input);
+    if(c != 0)
+        return c;
     if(exp != act.exp)
     {
         if(exp == nullptr)
             return -1;
         else if(act.exp == nullptr)
             return 1;
-        int c = exp->compare(*act.exp);
+        c = exp->compare(*act.exp);
         if(c != 0)
             return c;
     }
@@ -210,7 +341,7 @@ bool CCSAction::operator== (const CCSAction& act) const
 CCSTransition::CCSTransition()
 {}
 
-CCSTransition::CCSTransition(CCSAction act, shared_ptr<CCSProcess> from, shared_ptr<CCSProcess> to)
+CCSTransition::CCSTransition(CCSAction act, CCSRef<CCSProcess> from, CCSRef<CCSProcess> to)
     :act(act), from(from), to(to)
 {}
 
@@ -232,10 +363,10 @@ ostream& ccspp::operator<< (ostream& out, const CCSTransition& t)
 CCSAction CCSTransition::getAction() const
 { return act; }
 
-shared_ptr<CCSProcess> CCSTransition::getFrom() const
+CCSRef<CCSProcess> CCSTransition::getFrom() const
 { return from; }
 
-shared_ptr<CCSProcess> CCSTransition::getTo() const
+CCSRef<CCSProcess> CCSTransition::getTo() const
 { return to; }
 
 int CCSTransition::compare(const CCSTransition& t) const
@@ -257,9 +388,12 @@ bool CCSTransition::operator< (const CCSTransition& t) const
 CCSBinding::CCSBinding()
 {}
 
-CCSBinding::CCSBinding(string name, vector<string> params, shared_ptr<CCSProcess> process)
+CCSBinding::CCSBinding(string name, vector<string> params, CCSRef<CCSProcess> process)
     :name(name), params(params), process(process)
-{}
+{
+    for(const string& param : params)
+        paramIds.push_back(CCSSymbols::intern(param));
+}
 
 string CCSBinding::getName() const
 { return name; }
@@ -267,7 +401,17 @@ string CCSBinding::getName() const
 vector<string> CCSBinding::getParams() const
 { return params; }
 
-shared_ptr<CCSProcess> CCSBinding::getProcess() const
+const vector<uint32_t>& CCSBinding::getParamIds() const
+{ return paramIds; }
+
+CCSRef<CCSProcess> CCSBinding::instantiate(const vector<int>& args, bool fold) const
+{
+    if(paramIds.empty())
+        return process;
+    return process->subst(CCSEnv(paramIds, args), fold);
+}
+
+CCSRef<CCSProcess> CCSBinding::getProcess() const
 { return process; }
 
 void CCSBinding::print(ostream& out) const
@@ -299,35 +443,79 @@ ostream& ccspp::operator<< (ostream& out, const CCSBinding& b)
 
 
 
-void CCSProgram::addBinding(string name, vector<string> params, shared_ptr<CCSProcess> process)
-{ bindings[name] = CCSBinding(name, params, process); }
+size_t CCSProgram::InstanceHash::operator() (const Instance& i) const
+{
+    uint64_t h = hash_combine(i.name, i.fold);
+    for(int arg : i.args)
+        h = hash_combine(h, (uint32_t)arg);
+    return h;
+}
+
+void CCSProgram::addBinding(string name, vector<string> params, CCSRef<CCSProcess> process)
+{
+    bindings[name] = CCSBinding(name, params, process);
+    instances.clear();
+}
 
-void CCSProgram::setProcess(shared_ptr<CCSProcess> process)
+void CCSProgram::setProcess(CCSRef<CCSProcess> process)
 { this->process = process; }
 
-shared_ptr<CCSProcess> CCSProgram::get(string name, vector<int> args, bool fold) const
+CCSRef<CCSProcess> CCSProgram::get(string name, vector<int> args, bool fold) const
+{ return get(CCSSymbols::intern(name), args, fold); }
+
+CCSRef<CCSProcess> CCSProgram::get(uint32_t name, const vector<int>& args, bool fold) const
 {
-    if(bindings.count(name))
-    {
-        const CCSBinding& b = bindings.at(name);
-        vector<string> params = b.getParams();
-        if(args.size() != params.size())
-            return nullptr;
-        shared_ptr<CCSProcess> res = bindings.at(name).getProcess();
-        for(int i = params.size() - 1; i >= 0; i--)
-            res = res->subst(params[i], args[i], fold);
-        return res;
-    }
-    else
+    //the memo keeps the instances alive, so it is cleared when it gets too large
+    static const size_t maxInstances = 1 << 16;
+
+    Instance key{ name, fold, args };
+    CCSRef<CCSProcess>* memo = instances.find(key);
+    if(memo)
+        return *memo;
+
+    auto it = bindings.find(CCSSymbols::name(name));
+    if(it == bindings.end() || args.size() != it->second.getParamIds().size())
         return nullptr;
+    CCSRef<CCSProcess> res = it->second.instantiate(args, fold);
+    if(instances.size() >= maxInstances)
+        instances.clear();
+    instances.insert(key, res);
+    return res;
 }
 
 map<string, CCSBinding> CCSProgram::getBindings() const
 { return bindings; }
 
-shared_ptr<CCSProcess> CCSProgram::getProcess() const
+CCSRef<CCSProcess> CCSProgram::getProcess() const
 { return process; }
 
+void CCSProgram::setCacheSize(size_t entries)
+{
+    if(entries == 0)
+        cache = nullptr;
+    else
+        cache = make_shared<CCSTransitionCache>(entries);
+}
+
+CCSTransitionCache* CCSProgram::getCache() const
+{ return cache.get(); }
+
+void CCSProgram::setNormalize(bool normalize)
+{
+    if(!normalize)
+    {
+        normalizer = nullptr;
+        return;
+    }
+    //every program gets its own normalizer, since the memo is not thread-safe
+    normalizer = make_shared<CCSNormalizer>(*this);
+    if(process)
+        process = normalizer->normalize(process);
+}
+
+CCSNormalizer* CCSProgram::getNormalizer() const
+{ return normalizer.get(); }
+
 void CCSProgram::print(ostream& out) const
 {
     //does not work in gcc 6.3.0 :(
@@ -356,16 +544,16 @@ CCSException::CCSException(string message)
 
 
 
-CCSProcessException::CCSProcessException(shared_ptr<CCSProcess> process, string message)
+CCSProcessException::CCSProcessException(CCSRef<CCSProcess> process, string message)
     :CCSException(message), process(process)
 {}
 
-shared_ptr<CCSProcess> CCSProcessException::getProcess() const
+CCSRef<CCSProcess> CCSProcessException::getProcess() const
 { return process; }
 
 
 
-CCSRecursionException::CCSRecursionException(shared_ptr<CCSProcessName> process, string message)
+CCSRecursionException::CCSRecursionException(CCSRef<CCSProcessName> process, string message)
     :CCSProcessException(process, message), name(process->getName())
 {}
 
@@ -374,19 +562,19 @@ string CCSRecursionException::getName() const
 
 
 
-CCSExpException::CCSExpException(shared_ptr<CCSExp> exp, string message)
+CCSExpException::CCSExpException(CCSRef<CCSExp> exp, string message)
     :CCSException(message), exp(exp)
 {}
 
-shared_ptr<CCSExp> CCSExpException::getExp() const
+CCSRef<CCSExp> CCSExpException::getExp() const
 { return exp; }
 
-void CCSExpException::setExp(shared_ptr<CCSExp> exp)
+void CCSExpException::setExp(CCSRef<CCSExp> exp)
 { this->exp = exp; }
 
 
 
-CCSUnboundException::CCSUnboundException(shared_ptr<CCSExp> exp, string id, string message)
+CCSUnboundException::CCSUnboundException(CCSRef<CCSExp> exp, string id, string message)
     :CCSExpException(exp, message), id(id)
 {}
 
@@ -395,6 +583,6 @@ string CCSUnboundException::getId() const
 
 
 
-CCSUndefinedException::CCSUndefinedException(shared_ptr<CCSExp> exp, string message)
+CCSUndefinedException::CCSUndefinedException(CCSRef<CCSExp> exp, string message)
     :CCSExpException(exp, message)
 {}
@@ -1,17 +1,30 @@
 #ifndef CCSPP_CCS_H_INCLUDED
 #define CCSPP_CCS_H_INCLUDED
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <map>
 #include <vector>
 #include <iostream>
 
+#include "ccshash.h"
+#include "ccspool.h"
+#include "ccsref.h"
+
 namespace ccspp
 {
     class CCSExp;
     class CCSProcess;
     class CCSProcessName;
+    class CCSParallel;
+    class CCSRestrict;
+    class CCSSequential;
+    class CCSTransitionCache;
+    class CCSNormalizer;
+
+    template<typename T>
+    class CCSUniqueTable;
 
     template<typename T, typename V = void>
     class CCSVisitor;
@@ -19,6 +32,62 @@ namespace ccspp
     template<typename T, typename V = void>
     class CCSExpVisitor;
 
+    /** @brief Global table of interned names.
+
+        Action names and input variables are stored as small integer ids,
+        so actions can be compared and hashed without touching strings.
+        Id 0 is the empty name, all other ids are assigned in the order the names are first seen.
+        The table may be used by several threads at once.
+    */
+    class CCSSymbols
+    {
+    public:
+        /** @brief Returns the id of a name, adding it to the table if necessary. */
+        static uint32_t intern(const std::string& name);
+
+        /** @brief Returns the name of an id (without locking the table, unless the id is new to the calling thread). */
+        static const std::string& name(uint32_t id);
+    };
+
+    /** @brief Environment binding identifiers to values.
+
+        Used to substitute all parameters of a process in one pass (see CCSProcess::subst).
+        The identifiers are interned names, the binding of slot i is ids[i] = vals[i].
+        If an identifier is bound more than once, the last binding is used.
+        The mask has the bit idMask(id) set for every bound identifier, so a term whose identifiers
+        (see CCSExp::getVars and CCSProcess::getVars) do not intersect it is not affected by the substitution.
+    */
+    class CCSEnv
+    {
+    private:
+        std::vector<uint32_t> ids;
+        std::vector<int> vals;
+        uint64_t mask;
+
+    public:
+        /** @brief Constructs an empty environment. */
+        CCSEnv();
+
+        /** @brief Constructs an environment binding ids[i] to vals[i] (both vectors must have the same size). */
+        CCSEnv(std::vector<uint32_t> ids, std::vector<int> vals);
+
+        /** @brief Returns the bit of an identifier in variable masks. */
+        static uint64_t idMask(uint32_t id)
+        { return (uint64_t)1 << (id & 63); }
+
+        /** @brief Returns true if no identifier is bound. */
+        bool empty() const;
+
+        /** @brief Returns the mask of the bound identifiers. */
+        uint64_t getMask() const;
+
+        /** @brief Returns a pointer to the value of an identifier, or nullptr if it is not bound. */
+        const int* find(uint32_t id) const;
+
+        /** @brief Returns this environment without the bindings of an identifier. */
+        CCSEnv without(uint32_t id) const;
+    };
+
     /** @brief Represents a CCS action.
 
         A CCS action can be:
@@ -36,12 +105,15 @@ namespace ccspp
         The action `i` has type TAU, the action `e` has type DELTA.
         Actions with a `!` have type SEND and actions with `?` have type RECV.
         All other actions have type NONE.
+
+        Names and inputs are interned in CCSSymbols and expressions are hash-consed,
+        so comparing two actions for equality only compares integers and pointers.
     */
     class CCSAction
     {
     public:
         /** @brief Represents the type of a CCS action */
-        enum Type
+        enum Type : uint8_t
         {
             NONE = 0,   /**< action */
             TAU,        /**< internal action */
@@ -52,25 +124,25 @@ namespace ccspp
 
     private:
         Type type;
-        std::string name;
-        std::shared_ptr<CCSExp> param;
-        std::string input;
-        std::shared_ptr<CCSExp> exp;
+        uint32_t name;
+        uint32_t input;
+        CCSRef<CCSExp> param;
+        CCSRef<CCSExp> exp;
 
-        CCSAction(Type type, std::string name, std::shared_ptr<CCSExp> param, std::string input, std::shared_ptr<CCSExp> exp);
+        CCSAction(Type type, uint32_t name, CCSRef<CCSExp> param, uint32_t input, CCSRef<CCSExp> exp);
 
     public:
         /** @brief Constructs an empty CCSAction, i or e. */
         CCSAction(Type type = NONE);
 
         /** @brief Constructs a CCSAction name(param), name(param)! or name(param)? */
-        CCSAction(Type type, std::string name, std::shared_ptr<CCSExp> param = nullptr);
+        CCSAction(Type type, std::string name, CCSRef<CCSExp> param = nullptr);
 
         /** @brief Constructs a CCSAction name(param)?input */
-        CCSAction(Type type, std::string name, std::shared_ptr<CCSExp> param, std::string input);
+        CCSAction(Type type, std::string name, CCSRef<CCSExp> param, std::string input);
 
         /** @brief Constructs a CCSAction name(param)?exp or name(param)!exp */
-        CCSAction(Type type, std::string name, std::shared_ptr<CCSExp> param, std::shared_ptr<CCSExp> exp);
+        CCSAction(Type type, std::string name, CCSRef<CCSExp> param, CCSRef<CCSExp> exp);
 
         /** @brief Returns the type of the CCSAction. */
         Type getType() const;
@@ -78,14 +150,20 @@ namespace ccspp
         /** @brief Returns the name of the CCSAction. */
         std::string getName() const;
 
+        /** @brief Returns the interned name of the CCSAction (0 if there is no name). */
+        uint32_t getNameId() const;
+
         /** @brief Returns the parameter expression in act(param) */
-        std::shared_ptr<CCSExp> getParam() const;
+        CCSRef<CCSExp> getParam() const;
 
         /** @brief Returns the input in act?input */
         std::string getInput() const;
 
+        /** @brief Returns the interned input in act?input (0 if there is no input). */
+        uint32_t getInputId() const;
+
         /** @brief Returns the expression in act?exp or act!exp */
-        std::shared_ptr<CCSExp> getExp() const;
+        CCSRef<CCSExp> getExp() const;
 
         /** @brief Returns the action without expression or input. */
         CCSAction getBase() const;
@@ -96,9 +174,24 @@ namespace ccspp
         /** @brief Returns the action without type, parameter and expression or input. */
         CCSAction getNone() const;
 
+        /** @brief Returns true if act can synchronize with this action,
+            i.e. one is a SEND and the other a RECV action on the same name and parameter.
+            This is the same as getBase() == ~act.getBase(), but does not construct any actions.
+        */
+        bool isComplement(const CCSAction& act) const;
+
         /** @brief Substitutes variable to constant in expressions. */
         CCSAction subst(std::string id, int v, bool fold = true) const;
 
+        /** @brief Substitutes all identifiers bound in env in expressions. */
+        CCSAction subst(const CCSEnv& env, bool fold = true) const;
+
+        /** @brief Returns the mask of the identifiers in the expressions (see CCSEnv). */
+        uint64_t getVars() const;
+
+        /** @brief Returns true if substitution with folding would fold a constant subexpression. */
+        bool isFoldable() const;
+
         /** @brief Returns the action with evaluated expressions. */
         CCSAction eval() const;
 
@@ -111,7 +204,11 @@ namespace ccspp
         /** @brief Returns the complementary action (i.e. exchanges SEND and RECV). */
         CCSAction operator~ () const;
 
+        /** @brief Returns a hash of this CCSAction. */
+        uint64_t getHash() const;
+
         /** @brief Compares this CCSAction to another instance.
+            Names and inputs are ordered alphabetically (not by their ids, so the order of the interning does not matter).
             \returns -1 if this < p, 1 if this > p, 0 else.
         */
         int compare(const CCSAction& act) const;
@@ -133,10 +230,15 @@ namespace ccspp
     */
     class CCSTransition
     {
+        friend class CCSProcess;
+        friend class CCSParallel;
+        friend class CCSRestrict;
+        friend class CCSSequential;
+
     private:
         CCSAction act;
-        std::shared_ptr<CCSProcess> from;
-        std::shared_ptr<CCSProcess> to;
+        CCSRef<CCSProcess> from;
+        CCSRef<CCSProcess> to;
 
     public:
         /** @brief Empty constructor. */
@@ -149,16 +251,16 @@ namespace ccspp
             @param from The process on the left hand side.
             @param to The process on the right hand side.
         */
-        CCSTransition(CCSAction act, std::shared_ptr<CCSProcess> from, std::shared_ptr<CCSProcess> to);
+        CCSTransition(CCSAction act, CCSRef<CCSProcess> from, CCSRef<CCSProcess> to);
 
         /** @brief Return the action of the CCSTransition. */
         CCSAction getAction() const;
 
         /** @brief Return the left hand side process of the CCSTransition. */
-        std::shared_ptr<CCSProcess> getFrom() const;
+        CCSRef<CCSProcess> getFrom() const;
 
         /** @brief Return the right hand side process of the CCSTransition. */
-        std::shared_ptr<CCSProcess> getTo() const;
+        CCSRef<CCSProcess> getTo() const;
 
         /** @brief Prints the CCSTransition to an output stream. */
         void print(std::ostream& out) const;
@@ -181,14 +283,15 @@ namespace ccspp
     private:
         std::string name;
         std::vector<std::string> params;
-        std::shared_ptr<CCSProcess> process;
+        std::vector<uint32_t> paramIds;
+        CCSRef<CCSProcess> process;
 
     public:
         /** @brief Empty constructor (mainly for STL containers). */
         CCSBinding();
 
         /** @brief Constructs a CCSBinding name[params] := process */
-        CCSBinding(std::string name, std::vector<std::string> params, std::shared_ptr<CCSProcess> process);
+        CCSBinding(std::string name, std::vector<std::string> params, CCSRef<CCSProcess> process);
 
         /** @brief Returns the name of the process. */
         std::string getName() const;
@@ -196,8 +299,14 @@ namespace ccspp
         /** @brief Returns the parameters of the process. */
         std::vector<std::string> getParams() const;
 
+        /** @brief Returns the interned parameters, i.e. the environment slots of the parameters. */
+        const std::vector<uint32_t>& getParamIds() const;
+
+        /** @brief Returns the process with the parameters substituted by args in one pass. */
+        CCSRef<CCSProcess> instantiate(const std::vector<int>& args, bool fold = true) const;
+
         /** @brief Returns the process. */
-        std::shared_ptr<CCSProcess> getProcess() const;
+        CCSRef<CCSProcess> getProcess() const;
 
         /** @brief Prints the CCSBinding to an output stream. */
         void print(std::ostream& out) const;
@@ -210,24 +319,65 @@ namespace ccspp
     class CCSProgram
     {
     private:
+        struct Instance
+        {
+            uint32_t name;
+            bool fold;
+            std::vector<int> args;
+        };
+
+        struct InstanceHash
+        {
+            std::size_t operator() (const Instance& i) const;
+        };
+
+        struct InstanceEq
+        {
+            bool operator() (const Instance& i1, const Instance& i2) const
+            { return i1.name == i2.name && i1.fold == i2.fold && i1.args == i2.args; }
+        };
+
         std::map<std::string, CCSBinding> bindings;
-        std::shared_ptr<CCSProcess> process;
+        CCSRef<CCSProcess> process;
+        std::shared_ptr<CCSTransitionCache> cache;
+        std::shared_ptr<CCSNormalizer> normalizer;
+        mutable CCSHashMap<Instance, CCSRef<CCSProcess>, InstanceHash, InstanceEq> instances;
 
     public:
         /** @brief Add a binding to a named process. */
-        void addBinding(std::string name, std::vector<std::string> params, std::shared_ptr<CCSProcess> process);
+        void addBinding(std::string name, std::vector<std::string> params, CCSRef<CCSProcess> process);
 
         /** @brief Set the main process. */
-        void setProcess(std::shared_ptr<CCSProcess> process);
+        void setProcess(CCSRef<CCSProcess> process);
 
         /** @brief Get a named process. */
-        std::shared_ptr<CCSProcess> get(std::string name, std::vector<int> args, bool fold = true) const;
+        CCSRef<CCSProcess> get(std::string name, std::vector<int> args, bool fold = true) const;
+
+        /** @brief Get a named process by its interned name.
+            The instantiations are memoized, so instantiating the same process with the same arguments again
+            does not substitute the parameters again.
+        */
+        CCSRef<CCSProcess> get(uint32_t name, const std::vector<int>& args, bool fold = true) const;
 
         /** @brief Returns all bindings. */
         std::map<std::string, CCSBinding> getBindings() const;
 
         /** @brief Returns the main process. */
-        std::shared_ptr<CCSProcess> getProcess() const;
+        CCSRef<CCSProcess> getProcess() const;
+
+        /** @brief Enables the transition cache with at most entries entries (0 disables it). */
+        void setCacheSize(std::size_t entries);
+
+        /** @brief Returns the transition cache, or nullptr if it is disabled. */
+        CCSTransitionCache* getCache() const;
+
+        /** @brief Enables or disables the normalization of the successor states modulo structural congruence
+            (see CCSNormalizer). Enabling it also normalizes the main process.
+        */
+        void setNormalize(bool normalize);
+
+        /** @brief Returns the normalizer of the successor states, or nullptr if it is disabled. */
+        CCSNormalizer* getNormalizer() const;
 
         /** @brief Prints the CCSProgram to an output stream. */
         void print(std::ostream& out) const;
@@ -236,17 +386,63 @@ namespace ccspp
     /** @brief Prints a CCSProgram to an output stream */
     std::ostream& operator<< (std::ostream& out, const CCSProgram& p);
 
+    /** @brief Finalizes a 64 bit hash value (splitmix64). */
+    inline uint64_t hash_mix(uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    /** @brief Combines a hash value v into seed. */
+    inline uint64_t hash_combine(uint64_t seed, uint64_t v)
+    { return hash_mix(seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2))); }
+
+    /** @brief Hashes a string (FNV-1a), independent of the standard library implementation. */
+    inline uint64_t hash_string(const std::string& str)
+    {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for(char c : str)
+            h = (h ^ (unsigned char)c) * 0x100000001b3ULL;
+        return h;
+    }
+
     /** @brief Comparator functor to use CCS object pointers in STL containers. */
     template<typename T>
     class PtrCmp
     {
     public:
-        bool operator() (const std::shared_ptr<T>& p1, const std::shared_ptr<T>& p2) const
+        bool operator() (const CCSRef<T>& p1, const CCSRef<T>& p2) const
         {
             return *p1 < *p2;
         }
     };
 
+    /** @brief Hash functor to use CCS object pointers in hash containers. */
+    template<typename T>
+    class PtrHash
+    {
+    public:
+        std::size_t operator() (const CCSRef<T>& p) const
+        {
+            return p->getHash();
+        }
+    };
+
+    /** @brief Equality functor to use CCS object pointers in hash containers.
+        Hash-consed objects are equal iff they are the same object,
+        the structural comparison is only a fallback for objects created without make_process or make_exp.
+    */
+    template<typename T>
+    class PtrEq
+    {
+    public:
+        bool operator() (const CCSRef<T>& p1, const CCSRef<T>& p2) const
+        {
+            return p1 == p2 || (p1->getHash() == p2->getHash() && p1->compare(*p2) == 0);
+        }
+    };
+
     class CCSException : public std::runtime_error
     {
     public:
@@ -256,11 +452,11 @@ namespace ccspp
     class CCSProcessException : public CCSException
     {
     private:
-        std::shared_ptr<CCSProcess> process;
+        CCSRef<CCSProcess> process;
 
     public:
-        CCSProcessException(std::shared_ptr<CCSProcess> process, std::string message);
-        std::shared_ptr<CCSProcess> getProcess() const;
+        CCSProcessException(CCSRef<CCSProcess> process, std::string message);
+        CCSRef<CCSProcess> getProcess() const;
     };
 
     class CCSRecursionException : public CCSProcessException
@@ -269,19 +465,19 @@ namespace ccspp
         std::string name;
 
     public:
-        CCSRecursionException(std::shared_ptr<CCSProcessName> process, std::string message);
+        CCSRecursionException(CCSRef<CCSProcessName> process, std::string message);
         std::string getName() const;
     };
 
     class CCSExpException : public CCSException
     {
     private:
-        std::shared_ptr<CCSExp> exp;
+        CCSRef<CCSExp> exp;
 
     public:
-        CCSExpException(std::shared_ptr<CCSExp> exp, std::string message);
-        std::shared_ptr<CCSExp> getExp() const;
-        void setExp(std::shared_ptr<CCSExp> exp);
+        CCSExpException(CCSRef<CCSExp> exp, std::string message);
+        CCSRef<CCSExp> getExp() const;
+        void setExp(CCSRef<CCSExp> exp);
     };
 
     class CCSUnboundException : public CCSExpException
@@ -290,14 +486,25 @@ namespace ccspp
         std::string id;
 
     public:
-        CCSUnboundException(std::shared_ptr<CCSExp> exp, std::string id, std::string message);
+        CCSUnboundException(CCSRef<CCSExp> exp, std::string id, std::string message);
         std::string getId() const;
     };
 
     class CCSUndefinedException : public CCSExpException
     {
     public:
-        CCSUndefinedException(std::shared_ptr<CCSExp> exp, std::string message);
+        CCSUndefinedException(CCSRef<CCSExp> exp, std::string message);
+    };
+}
+
+namespace std
+{
+    /** @brief Hash functor to use CCSActions in hash containers. */
+    template<>
+    struct hash<ccspp::CCSAction>
+    {
+        std::size_t operator() (const ccspp::CCSAction& act) const
+        { return act.getHash(); }
     };
 }
 
@@ -0,0 +1,528 @@
+#include "ccsbisim.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+using namespace std;
+using namespace ccspp;
+
+//an element of a signature: the action of a transition and the block of its target
+typedef pair<uint32_t, uint32_t> SigPair;
+
+//initial partition: the explored states, the states with an error and every unexplored state on its own
+static uint32_t initialPartition(const CCSLTS& lts, vector<uint32_t>& block)
+{
+    uint32_t n = lts.getStateCount();
+    uint32_t explored = lts.getExploredCount();
+    block.resize(n);
+    uint32_t count = 0, normal = CCSLTS::npos, error = CCSLTS::npos;
+    for(uint32_t s = 0; s < n; s++)
+        if(s >= explored)
+            block[s] = count++;
+        else if(lts.isError(s))
+        {
+            if(error == CCSLTS::npos)
+                error = count++;
+            block[s] = error;
+        }
+        else
+        {
+            if(normal == CCSLTS::npos)
+                normal = count++;
+            block[s] = normal;
+        }
+    return count;
+}
+
+//refines the partition to the coarsest strong bisimulation and returns the number of blocks
+static uint32_t refineStrong(const CCSLTS& lts, vector<uint32_t>& block, uint32_t count)
+{
+    uint32_t n = lts.getStateCount();
+    uint32_t explored = lts.getExploredCount();
+
+    //the states of a block are never enumerated, only counted
+    vector<uint32_t> sizes(count, 0);
+    for(uint32_t s = 0; s < n; s++)
+        sizes[block[s]]++;
+
+    //the predecessors of state s are preds[predOffsets[s]] to preds[predOffsets[s + 1] - 1]
+    vector<size_t> predOffsets(n + 1, 0);
+    for(uint32_t s = 0; s < explored; s++)
+        for(const CCSLTS::Edge* e = lts.beginEdges(s); e != lts.endEdges(s); e++)
+            predOffsets[e->target + 1]++;
+    for(uint32_t s = 0; s < n; s++)
+        predOffsets[s + 1] += predOffsets[s];
+    vector<uint32_t> preds(predOffsets[n]);
+    {
+        vector<size_t> fill(predOffsets.begin(), predOffsets.end() - 1);
+        for(uint32_t s = 0; s < explored; s++)
+            for(const CCSLTS::Edge* e = lts.beginEdges(s); e != lts.endEdges(s); e++)
+                preds[fill[e->target]++] = s;
+    }
+
+    //the signature shared by the states of a block that were not recomputed
+    vector<vector<SigPair>> blockSigs(count);
+    vector<bool> isDirty(n, false);
+    vector<uint32_t> dirty;
+    for(uint32_t s = 0; s < explored; s++)
+        if(!lts.isError(s))
+        {
+            isDirty[s] = true;
+            dirty.push_back(s);
+        }
+
+    vector<SigPair> sigs;
+    vector<size_t> sigOffsets;
+    vector<uint32_t> order, next;
+    vector<pair<size_t, size_t>> groups;
+    while(!dirty.empty())
+    {
+        sort(dirty.begin(), dirty.end(), [&](uint32_t s1, uint32_t s2)
+            { return block[s1] < block[s2] || (block[s1] == block[s2] && s1 < s2); });
+
+        //the signatures are computed before any block is split, so they all refer to the same partition
+        sigs.clear();
+        sigOffsets.assign(1, 0);
+        for(uint32_t s : dirty)
+        {
+            size_t first = sigs.size();
+            for(const CCSLTS::Edge* e = lts.beginEdges(s); e != lts.endEdges(s); e++)
+                sigs.push_back({ e->action, block[e->target] });
+            sort(sigs.begin() + first, sigs.end());
+            sigs.erase(unique(sigs.begin() + first, sigs.end()), sigs.end());
+            sigOffsets.push_back(sigs.size());
+            isDirty[s] = false;
+        }
+        auto sigBegin = [&](size_t i) { return sigs.begin() + sigOffsets[i]; };
+        auto sigEnd = [&](size_t i) { return sigs.begin() + sigOffsets[i + 1]; };
+        auto sigEqual = [&](size_t i, const vector<SigPair>& sig)
+            { return equal(sigBegin(i), sigEnd(i), sig.begin(), sig.end()); };
+
+        next.clear();
+        for(size_t i = 0; i < dirty.size();)
+        {
+            uint32_t b = block[dirty[i]];
+            size_t j = i;
+            while(j < dirty.size() && block[dirty[j]] == b)
+                j++;
+
+            //groups of the dirty states of the block with equal signatures
+            order.clear();
+            for(size_t k = i; k < j; k++)
+                order.push_back(k);
+            sort(order.begin(), order.end(), [&](size_t k1, size_t k2)
+                { return lexicographical_compare(sigBegin(k1), sigEnd(k1), sigBegin(k2), sigEnd(k2)); });
+            groups.clear();
+            for(size_t k = 0; k < order.size(); k++)
+                if(k == 0 || !equal(sigBegin(order[k - 1]), sigEnd(order[k - 1]), sigBegin(order[k]), sigEnd(order[k])))
+                    groups.push_back({ k, k + 1 });
+                else
+                    groups.back().second = k + 1;
+
+            //the clean states keep the block, so only dirty states move; otherwise the largest group keeps it
+            bool clean = j - i < sizes[b];
+            size_t keep = groups.size();
+            for(size_t g = 0; g < groups.size(); g++)
+                if(clean ? sigEqual(order[groups[g].first], blockSigs[b])
+                    : keep == groups.size() || groups[g].second - groups[g].first > groups[keep].second - groups[keep].first)
+                    keep = g;
+
+            for(size_t g = 0; g < groups.size(); g++)
+            {
+                if(g == keep)
+                    continue;
+                uint32_t c = sizes.size();
+                for(size_t k = groups[g].first; k < groups[g].second; k++)
+                {
+                    uint32_t s = dirty[order[k]];
+                    block[s] = c;
+                    for(size_t p = predOffsets[s]; p < predOffsets[s + 1]; p++)
+                        if(!isDirty[preds[p]])
+                        {
+                            isDirty[preds[p]] = true;
+                            next.push_back(preds[p]);
+                        }
+                }
+                sizes[b] -= groups[g].second - groups[g].first;
+                sizes.push_back(groups[g].second - groups[g].first);
+                blockSigs.emplace_back(sigBegin(order[groups[g].first]), sigEnd(order[groups[g].first]));
+            }
+            if(keep != groups.size() && !clean)
+                blockSigs[b].assign(sigBegin(order[groups[keep].first]), sigEnd(order[groups[keep].first]));
+            i = j;
+        }
+        swap(dirty, next);
+    }
+    return sizes.size();
+}
+
+//computes the strongly connected components of the tau transitions (Tarjan's algorithm without recursion),
+//numbered in the order they are completed, so a tau transition never leads to a component with a higher number
+static uint32_t tauComponents(const CCSLTS& lts, uint32_t tau, vector<uint32_t>& comp)
+{
+    uint32_t n = lts.getStateCount();
+    vector<uint32_t> index(n, CCSLTS::npos), low(n), stack;
+    vector<pair<uint32_t, const CCSLTS::Edge*>> calls;
+    comp.assign(n, CCSLTS::npos);
+    uint32_t next = 0, count = 0;
+    for(uint32_t root = 0; root < n; root++)
+    {
+        if(index[root] != CCSLTS::npos)
+            continue;
+        index[root] = low[root] = next++;
+        stack.push_back(root);
+        calls.push_back({ root, lts.beginEdges(root) });
+        while(!calls.empty())
+        {
+            uint32_t v = calls.back().first;
+            const CCSLTS::Edge*& e = calls.back().second;
+            for(; e != lts.endEdges(v); e++)
+            {
+                if(e->action != tau)
+                    continue;
+                uint32_t w = e->target;
+                if(index[w] == CCSLTS::npos)
+                    break;
+                //a target on the stack has no component yet
+                if(comp[w] == CCSLTS::npos)
+                    low[v] = min(low[v], index[w]);
+            }
+            if(e != lts.endEdges(v))
+            {
+                uint32_t w = (e++)->target;
+                index[w] = low[w] = next++;
+                stack.push_back(w);
+                calls.push_back({ w, lts.beginEdges(w) });
+                continue;
+            }
+
+            calls.pop_back();
+            if(low[v] == index[v])
+            {
+                uint32_t w;
+                do
+                {
+                    w = stack.back();
+                    stack.pop_back();
+                    comp[w] = count;
+                }
+                while(w != v);
+                count++;
+            }
+            if(!calls.empty())
+                low[calls.back().first] = min(low[calls.back().first], low[v]);
+        }
+    }
+    return count;
+}
+
+//merges the sorted signature sig into the sorted signature out
+static void merge(vector<SigPair>& out, const vector<SigPair>& sig, vector<SigPair>& scratch)
+{
+    scratch.clear();
+    set_union(out.begin(), out.end(), sig.begin(), sig.end(), back_inserter(scratch));
+    swap(out, scratch);
+}
+
+//refines the partition to the coarsest branching (or weak) bisimulation and returns the number of blocks
+static uint32_t refineInert(const CCSLTS& lts, uint32_t tau, bool weak, vector<uint32_t>& block, uint32_t count)
+{
+    uint32_t n = lts.getStateCount();
+    vector<uint32_t> comp;
+    uint32_t comps = tauComponents(lts, tau, comp);
+
+    //the edges of component c are edges[offsets[c]] to edges[offsets[c + 1] - 1], without tau transitions within it;
+    //all states of a component are in the same block, since only explored states without errors have tau transitions
+    vector<size_t> offsets(comps + 1, 0);
+    vector<uint32_t> members(n);
+    for(uint32_t s = 0; s < n; s++)
+        offsets[comp[s] + 1]++;
+    for(uint32_t c = 0; c < comps; c++)
+        offsets[c + 1] += offsets[c];
+    {
+        vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for(uint32_t s = 0; s < n; s++)
+            members[fill[comp[s]]++] = s;
+    }
+    vector<uint32_t> compBlock(comps);
+    vector<CCSLTS::Edge> edges;
+    for(uint32_t c = 0; c < comps; c++)
+    {
+        size_t first = edges.size();
+        compBlock[c] = block[members[offsets[c]]];
+        for(size_t i = offsets[c]; i < offsets[c + 1]; i++)
+            for(const CCSLTS::Edge* e = lts.beginEdges(members[i]); e != lts.endEdges(members[i]); e++)
+                if(e->action != tau || comp[e->target] != c)
+                    edges.push_back({ e->action, comp[e->target] });
+        sort(edges.begin() + first, edges.end(), [](const CCSLTS::Edge& e1, const CCSLTS::Edge& e2)
+            { return e1.action < e2.action || (e1.action == e2.action && e1.target < e2.target); });
+        edges.erase(unique(edges.begin() + first, edges.end(), [](const CCSLTS::Edge& e1, const CCSLTS::Edge& e2)
+            { return e1.action == e2.action && e1.target == e2.target; }), edges.end());
+        offsets[c] = first;
+    }
+    offsets[comps] = edges.size();
+
+    //the predecessors of component c are preds[predOffsets[c]] to preds[predOffsets[c + 1] - 1],
+    //with the action of the edge and the predecessor (as an edge backwards)
+    vector<size_t> predOffsets(comps + 1, 0);
+    for(const CCSLTS::Edge& e : edges)
+        predOffsets[e.target + 1]++;
+    for(uint32_t c = 0; c < comps; c++)
+        predOffsets[c + 1] += predOffsets[c];
+    vector<CCSLTS::Edge> preds(edges.size());
+    {
+        vector<size_t> fill(predOffsets.begin(), predOffsets.end() - 1);
+        for(uint32_t c = 0; c < comps; c++)
+            for(size_t i = offsets[c]; i < offsets[c + 1]; i++)
+                preds[fill[edges[i].target]++] = { edges[i].action, c };
+    }
+
+    //the components of a block are never enumerated, only counted
+    vector<uint32_t> sizes(count, 0);
+    for(uint32_t c = 0; c < comps; c++)
+        sizes[compBlock[c]]++;
+
+    //sigs are the signatures (only the visible actions for weak), reach are the blocks reachable by tau transitions;
+    //like for strong bisimilarity, only the components that depend on a component that moved to another block are
+    //computed again, and blockSigs and blockReach are shared by the components of a block that were not
+    vector<vector<SigPair>> sigs(comps), blockSigs(count);
+    vector<vector<uint32_t>> reach(weak ? comps : 0), blockReach(weak ? count : 0);
+    vector<SigPair> sig, scratch;
+    vector<uint32_t> r, united;
+
+    //the components waiting in a queue are always computed in increasing order, so a component is computed
+    //after the components it reaches by tau transitions (which have lower numbers) in the same round
+    vector<bool> queued(comps, false);
+    vector<uint32_t> queue;
+    auto push = [&](uint32_t c)
+    {
+        if(queued[c])
+            return;
+        queued[c] = true;
+        queue.push_back(c);
+        push_heap(queue.begin(), queue.end(), greater<uint32_t>());
+    };
+    auto pop = [&]()
+    {
+        pop_heap(queue.begin(), queue.end(), greater<uint32_t>());
+        uint32_t c = queue.back();
+        queue.pop_back();
+        queued[c] = false;
+        return c;
+    };
+    auto pushPreds = [&](uint32_t c, bool onlyTau)
+    {
+        for(size_t i = predOffsets[c]; i < predOffsets[c + 1]; i++)
+            if(!onlyTau || preds[i].action == tau)
+                push(preds[i].target);
+    };
+
+    vector<uint32_t> moved(comps), reached, dirty;
+    for(uint32_t c = 0; c < comps; c++)
+        moved[c] = c;
+    vector<pair<size_t, size_t>> groups;
+    while(!moved.empty())
+    {
+        //a component that moved changes the reachable blocks of all components that reach it by tau transitions,
+        //and these change the signatures of their predecessors
+        if(weak)
+        {
+            for(uint32_t c : moved)
+                push(c);
+            while(!queue.empty())
+            {
+                uint32_t c = pop();
+                r.assign(1, compBlock[c]);
+                for(size_t i = offsets[c]; i < offsets[c + 1]; i++)
+                    if(edges[i].action == tau)
+                    {
+                        united.clear();
+                        set_union(r.begin(), r.end(), reach[edges[i].target].begin(), reach[edges[i].target].end(),
+                            back_inserter(united));
+                        r.swap(united);
+                    }
+                if(r != reach[c])
+                {
+                    reach[c].swap(r);
+                    pushPreds(c, true);
+                    reached.push_back(c);
+                }
+            }
+        }
+
+        //the signature of a component depends on its own block and the blocks of its successors,
+        //and it inherits the signatures of the components it reaches by (inert) tau transitions
+        for(uint32_t c : moved)
+        {
+            push(c);
+            pushPreds(c, false);
+        }
+        for(uint32_t c : reached)
+            pushPreds(c, false);
+        reached.clear();
+        dirty.clear();
+        while(!queue.empty())
+        {
+            uint32_t c = pop();
+            sig.clear();
+            auto inherits = [&](const CCSLTS::Edge& e)
+                { return e.action == tau && (weak || compBlock[e.target] == compBlock[c]); };
+            for(size_t i = offsets[c]; i < offsets[c + 1]; i++)
+                if(inherits(edges[i]))
+                    continue;
+                else if(weak)
+                    for(uint32_t b : reach[edges[i].target])
+                        sig.push_back({ edges[i].action, b });
+                else
+                    sig.push_back({ edges[i].action, compBlock[edges[i].target] });
+            sort(sig.begin(), sig.end());
+            sig.erase(unique(sig.begin(), sig.end()), sig.end());
+            for(size_t i = offsets[c]; i < offsets[c + 1]; i++)
+                if(inherits(edges[i]))
+                    merge(sig, sigs[edges[i].target], scratch);
+            if(sig != sigs[c])
+            {
+                sigs[c].swap(sig);
+                pushPreds(c, true);
+            }
+            dirty.push_back(c);
+        }
+
+        //the signatures are computed before any block is split, so they all refer to the same partition
+        auto sigLess = [&](uint32_t c1, uint32_t c2)
+        {
+            if(compBlock[c1] != compBlock[c2])
+                return compBlock[c1] < compBlock[c2];
+            if(weak && reach[c1] != reach[c2])
+                return reach[c1] < reach[c2];
+            return sigs[c1] < sigs[c2];
+        };
+        auto sigEqual = [&](uint32_t c, uint32_t b)
+            { return (!weak || reach[c] == blockReach[b]) && sigs[c] == blockSigs[b]; };
+        sort(dirty.begin(), dirty.end(), sigLess);
+
+        moved.clear();
+        for(size_t i = 0; i < dirty.size();)
+        {
+            uint32_t b = compBlock[dirty[i]];
+            size_t j = i;
+            while(j < dirty.size() && compBlock[dirty[j]] == b)
+                j++;
+
+            //groups of the dirty components of the block with equal signatures
+            groups.clear();
+            for(size_t k = i; k < j; k++)
+                if(k == i || sigLess(dirty[k - 1], dirty[k]))
+                    groups.push_back({ k, k + 1 });
+                else
+                    groups.back().second = k + 1;
+
+            //the clean components keep the block, so only dirty components move; otherwise the largest group keeps it
+            bool clean = j - i < sizes[b];
+            size_t keep = groups.size();
+            for(size_t g = 0; g < groups.size(); g++)
+                if(clean ? sigEqual(dirty[groups[g].first], b)
+                    : keep == groups.size() || groups[g].second - groups[g].first > groups[keep].second - groups[keep].first)
+                    keep = g;
+
+            for(size_t g = 0; g < groups.size(); g++)
+            {
+                uint32_t c = dirty[groups[g].first];
+                if(g == keep)
+                {
+                    if(!clean)
+                    {
+                        blockSigs[b] = sigs[c];
+                        if(weak)
+                            blockReach[b] = reach[c];
+                    }
+                    continue;
+                }
+                uint32_t nb = sizes.size();
+                for(size_t k = groups[g].first; k < groups[g].second; k++)
+                {
+                    compBlock[dirty[k]] = nb;
+                    moved.push_back(dirty[k]);
+                }
+                sizes[b] -= groups[g].second - groups[g].first;
+                sizes.push_back(groups[g].second - groups[g].first);
+                blockSigs.push_back(sigs[c]);
+                if(weak)
+                    blockReach.push_back(reach[c]);
+            }
+            i = j;
+        }
+    }
+
+    for(uint32_t s = 0; s < n; s++)
+        block[s] = compBlock[comp[s]];
+    return sizes.size();
+}
+
+CCSBisimulation::CCSBisimulation(const CCSLTS& lts, Equivalence equivalence)
+    :equivalence(equivalence)
+{
+    uint32_t n = lts.getStateCount();
+    vector<uint32_t> block;
+    uint32_t count = initialPartition(lts, block);
+    uint32_t tau = lts.getActionId(CCSAction(CCSAction::TAU));
+    if(equivalence == STRONG || tau == CCSLTS::npos)
+        count = refineStrong(lts, block, count);
+    else
+        count = refineInert(lts, tau, equivalence == WEAK, block, count);
+
+    //the blocks are numbered again by their first state
+    vector<uint32_t> ids(count, CCSLTS::npos);
+    blocks.resize(n);
+    for(uint32_t s = 0; s < n; s++)
+    {
+        if(ids[block[s]] == CCSLTS::npos)
+        {
+            ids[block[s]] = representatives.size();
+            representatives.push_back(s);
+        }
+        blocks[s] = ids[block[s]];
+    }
+}
+
+uint32_t CCSBisimulation::getBlockCount() const
+{ return representatives.size(); }
+
+uint32_t CCSBisimulation::getBlock(uint32_t s) const
+{ return blocks[s]; }
+
+uint32_t CCSBisimulation::getRepresentative(uint32_t b) const
+{ return representatives[b]; }
+
+void CCSBisimulation::quotient(const CCSLTS& lts, CCSLTS& out) const
+{
+    for(uint32_t r : representatives)
+        out.addState(lts.getProcess(r));
+
+    //the edges of all states are collected by block, since bisimilar states may have different edges (but for strong)
+    uint32_t tau = lts.getActionId(CCSAction(CCSAction::TAU));
+    vector<pair<uint32_t, CCSLTS::Edge>> all;
+    for(uint32_t s = 0; s < lts.getExploredCount(); s++)
+        for(const CCSLTS::Edge* e = lts.beginEdges(s); e != lts.endEdges(s); e++)
+            if(equivalence == STRONG || e->action != tau || blocks[e->target] != blocks[s])
+                all.push_back({ blocks[s], { out.internAction(lts.getAction(e->action)), blocks[e->target] } });
+    sort(all.begin(), all.end(), [](const pair<uint32_t, CCSLTS::Edge>& e1, const pair<uint32_t, CCSLTS::Edge>& e2)
+    {
+        if(e1.first != e2.first)
+            return e1.first < e2.first;
+        return e1.second.action < e2.second.action || (e1.second.action == e2.second.action && e1.second.target < e2.second.target);
+    });
+
+    //the blocks of the explored states come first, so their edges are added in the order of the states
+    vector<CCSLTS::Edge> edges;
+    size_t i = 0;
+    for(uint32_t b = 0; b < representatives.size() && representatives[b] < lts.getExploredCount(); b++)
+    {
+        edges.clear();
+        for(; i < all.size() && all[i].first == b; i++)
+            if(edges.empty() || edges.back().action != all[i].second.action || edges.back().target != all[i].second.target)
+                edges.push_back(all[i].second);
+        out.addEdges(edges, lts.isError(representatives[b]));
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef CCSPP_CCSBISIM_H_INCLUDED
+#define CCSPP_CCSBISIM_H_INCLUDED
+
+#include "ccslts.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ccspp
+{
+    /** @brief The coarsest strong, branching or weak bisimulation of an explicit LTS,
+        i.e. its states partitioned into blocks of bisimilar states.
+
+        The partition is computed by signature refinement: the signature of a state is the set of pairs of the actions
+        and the blocks of the targets of its transitions, and a block is split until all its states have the same signature.
+        For strong bisimilarity, only the signatures of the predecessors of states that moved to another block are computed
+        again, and the states with an unchanged signature keep their block, so the refinement does not touch the stable
+        parts of the LTS again.
+
+        For branching and weak bisimilarity, the strongly connected components of the tau transitions are collapsed first
+        (Tarjan's algorithm), since their states are bisimilar, so the remaining tau transitions are acyclic. The signatures
+        are then refined like for strong bisimilarity, but computed in reverse topological order of the tau transitions,
+        and a changed signature also makes the components that reach it by tau transitions compute theirs again:
+        the branching signature of a state also contains the signatures of the states it reaches by inert tau transitions
+        (within its block), which are not part of the signature themselves; the weak signature contains the actions
+        with the blocks reachable by tau transitions before and after them, and a tau with every block reachable by
+        tau transitions (including its own). Divergence (tau cycles) is not distinguished from deadlock.
+
+        States with an error are bisimilar to each other, but not to any other state. The unexplored states are
+        not bisimilar to any other state, since their transitions are unknown.
+        The blocks are numbered by their first state, so the block of the initial state is 0 and the blocks of the
+        explored states come first.
+    */
+    class CCSBisimulation
+    {
+    public:
+        /** @brief The equivalence to compute. */
+        enum Equivalence
+        {
+            STRONG = 0,
+            BRANCHING,
+            WEAK
+        };
+
+    private:
+        Equivalence equivalence;
+        std::vector<uint32_t> blocks;
+        std::vector<uint32_t> representatives;
+
+    public:
+        /** @brief Computes the coarsest bisimulation of an LTS. */
+        CCSBisimulation(const CCSLTS& lts, Equivalence equivalence = STRONG);
+
+        /** @brief Returns the number of blocks. */
+        uint32_t getBlockCount() const;
+
+        /** @brief Returns the block of a state. */
+        uint32_t getBlock(uint32_t s) const;
+
+        /** @brief Returns the first state of a block. */
+        uint32_t getRepresentative(uint32_t b) const;
+
+        /** @brief Builds the quotient of the LTS in out (which must be empty).
+            The states of the quotient are the blocks, with the processes of their representatives,
+            its edges are the edges of all states, with the blocks of the targets as targets and without duplicates.
+            For branching and weak bisimilarity, the tau transitions within a block are left out.
+        */
+        void quotient(const CCSLTS& lts, CCSLTS& out) const;
+    };
+}
+
+#endif //CCSPP_CCSBISIM_H_INCLUDED
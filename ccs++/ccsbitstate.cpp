@@ -0,0 +1,78 @@
+#include "ccsbitstate.h"
+#include "ccs.h"
+#include <bitset>
+#include <cmath>
+
+using namespace std;
+using namespace ccspp;
+
+//the probability that all k bits of a new state are set after n states were stored in m bits
+static double falsePositive(double n, double m, unsigned k)
+{ return pow(1 - exp(-(double)k * n / m), k); }
+
+CCSBitState::CCSBitState(unsigned bits, unsigned k)
+    :bits(bits), k(k), stored(0)
+{
+    if(bits < 6 || bits > 40)
+        throw CCSException("invalid size of the bit-state table");
+    size_t n = (size_t)1 << (bits - 6);
+    words.reset(new atomic<uint64_t>[n]);
+    for(size_t i = 0; i < n; i++)
+        words[i].store(0, memory_order_relaxed);
+}
+
+bool CCSBitState::insert(uint64_t hash)
+{
+    //double hashing: the bits are h1, h1 + h2, h1 + 2 h2, ... with an odd h2
+    uint64_t mask = getBits() - 1;
+    uint64_t h1 = hash;
+    uint64_t h2 = hash_mix(hash) | 1;
+    bool inserted = false;
+    for(unsigned i = 0; i < k; i++)
+    {
+        uint64_t bit = (h1 + i * h2) & mask;
+        uint64_t m = (uint64_t)1 << (bit & 63);
+        if(!(words[bit >> 6].fetch_or(m, memory_order_relaxed) & m))
+            inserted = true;
+    }
+    if(inserted)
+        stored.fetch_add(1, memory_order_relaxed);
+    return inserted;
+}
+
+uint64_t CCSBitState::getStored() const
+{ return stored.load(memory_order_relaxed); }
+
+uint64_t CCSBitState::getBits() const
+{ return (uint64_t)1 << bits; }
+
+unsigned CCSBitState::getHashes() const
+{ return k; }
+
+double CCSBitState::getFill() const
+{
+    uint64_t set = 0;
+    for(size_t i = 0; i < getBits() / 64; i++)
+        set += bitset<64>(words[i].load(memory_order_relaxed)).count();
+    return (double)set / getBits();
+}
+
+double CCSBitState::getOmissionProbability() const
+{ return falsePositive(getStored(), getBits(), k); }
+
+double CCSBitState::getExpectedOmissions() const
+{
+    //integrates the omission probability over the inserts (it only grows, so the midpoints of a few intervals suffice)
+    double n = getStored();
+    const int steps = 1000;
+    double res = 0;
+    for(int i = 0; i < steps; i++)
+        res += falsePositive(n * (i + 0.5) / steps, getBits(), k);
+    return res * n / steps;
+}
+
+double CCSBitState::getCoverage() const
+{
+    double n = getStored();
+    return n == 0 ? 1 : n / (n + getExpectedOmissions());
+}
@@ -0,0 +1,58 @@
+#ifndef CCSPP_CCSBITSTATE_H_INCLUDED
+#define CCSPP_CCSBITSTATE_H_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ccspp
+{
+    /** @brief Bit-state (supertrace) visited table.
+
+        A state is only stored as k bits of a large bit array, chosen by its hash (double hashing).
+        A state is considered visited if all of its bits are set, so a state whose bits were all set by other states
+        is wrongly considered visited and omitted (together with the states only reachable through it).
+        The memory does not grow with the number of states, so a search with a bit-state table always finishes,
+        but may only cover a part of the state space. The table may be used by several threads at once.
+    */
+    class CCSBitState
+    {
+    private:
+        unsigned bits;
+        unsigned k;
+        std::unique_ptr<std::atomic<uint64_t>[]> words;
+        std::atomic<uint64_t> stored;
+
+    public:
+        /** @brief Constructs an empty table of 2^bits bits (6 <= bits <= 40) using k bits per state. */
+        CCSBitState(unsigned bits, unsigned k = 3);
+
+        /** @brief Sets the bits of a state hash. \returns true if not all of them were set before. */
+        bool insert(uint64_t hash);
+
+        /** @brief Returns the number of states stored, i.e. the number of inserts that returned true. */
+        uint64_t getStored() const;
+
+        /** @brief Returns the number of bits of the table. */
+        uint64_t getBits() const;
+
+        /** @brief Returns the number of bits per state. */
+        unsigned getHashes() const;
+
+        /** @brief Returns the fraction of the bits that are set. */
+        double getFill() const;
+
+        /** @brief Returns the probability that inserting a new state now would wrongly find it visited. */
+        double getOmissionProbability() const;
+
+        /** @brief Returns the expected number of states omitted so far,
+            estimated from the number of states stored (each insert had the omission probability of its time).
+        */
+        double getExpectedOmissions() const;
+
+        /** @brief Returns the estimated fraction of the reached states that were stored. */
+        double getCoverage() const;
+    };
+}
+
+#endif //CCSPP_CCSBITSTATE_H_INCLUDED
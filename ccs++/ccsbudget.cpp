@@ -0,0 +1,47 @@
+#include "ccsbudget.h"
+#include <sys/resource.h>
+
+using namespace std;
+using namespace ccspp;
+
+CCSBudget::CCSBudget(size_t maxStates, size_t maxMemory, double timeout)
+    :maxStates(maxStates), maxMemory(maxMemory), timeout(timeout), start(chrono::steady_clock::now()), calls(0), limit(NONE)
+{}
+
+bool CCSBudget::exceeded(size_t states)
+{
+    if(limit.load(memory_order_relaxed) != NONE)
+        return true;
+
+    int l = NONE;
+    if(maxStates != 0 && states >= maxStates)
+        l = STATES;
+    else if(calls.fetch_add(1, memory_order_relaxed) % checkInterval == 0)
+    {
+        if(maxMemory != 0 && getPeakMemory() >= maxMemory)
+            l = MEMORY;
+        else if(timeout > 0 && getElapsed() >= timeout)
+            l = TIME;
+    }
+    if(l == NONE)
+        return false;
+
+    //the first limit exceeded is kept
+    int none = NONE;
+    limit.compare_exchange_strong(none, l);
+    return true;
+}
+
+CCSBudget::Limit CCSBudget::getExceeded() const
+{ return (Limit)limit.load(); }
+
+double CCSBudget::getElapsed() const
+{ return chrono::duration<double>(chrono::steady_clock::now() - start).count(); }
+
+size_t CCSBudget::getPeakMemory()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    //the maximum resident set size is in kilobytes
+    return (size_t)usage.ru_maxrss * 1024;
+}
@@ -0,0 +1,64 @@
+#ifndef CCSPP_CCSBUDGET_H_INCLUDED
+#define CCSPP_CCSBUDGET_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ccspp
+{
+    /** @brief Limits of the resources of an exploration: the number of states, the peak memory and the time.
+
+        The explorers call exceeded before they explore a state and stop cleanly if a limit is exceeded,
+        reporting the discovered but unexplored states like at the maximum depth.
+        The memory and the time are only checked every few calls, since they need system calls.
+        The limits are checked against the state counts of the explorers, which may already have stored
+        some more states (e.g. the next layer of a breadth-first search). May be used by several threads at once.
+    */
+    class CCSBudget
+    {
+    public:
+        /** @brief The limit that stopped an exploration. */
+        enum Limit
+        {
+            NONE = 0,
+            STATES,
+            MEMORY,
+            TIME
+        };
+
+    private:
+        static const unsigned checkInterval = 256;
+
+        std::size_t maxStates;
+        std::size_t maxMemory;
+        double timeout;
+        std::chrono::steady_clock::time_point start;
+        std::atomic<unsigned> calls;
+        std::atomic<int> limit;
+
+    public:
+        /** @brief Constructs a budget, starting the clock.
+            @param maxStates The maximum number of states, or 0.
+            @param maxMemory The maximum peak memory (resident set size) of the process in bytes, or 0.
+            @param timeout The maximum time in seconds, or 0.
+        */
+        CCSBudget(std::size_t maxStates = 0, std::size_t maxMemory = 0, double timeout = 0);
+
+        /** @brief Returns true if a limit is exceeded (always, once one was exceeded).
+            @param states The number of states explored or discovered so far.
+        */
+        bool exceeded(std::size_t states);
+
+        /** @brief Returns the limit that was exceeded, or NONE. */
+        Limit getExceeded() const;
+
+        /** @brief Returns the seconds since the construction of the budget. */
+        double getElapsed() const;
+
+        /** @brief Returns the peak memory (resident set size) of the process in bytes. */
+        static std::size_t getPeakMemory();
+    };
+}
+
+#endif //CCSPP_CCSBUDGET_H_INCLUDED
@@ -0,0 +1,90 @@
+#include "ccscache.h"
+#include "ccsprocess.h"
+#include <algorithm>
+
+using namespace std;
+using namespace ccspp;
+
+CCSTransitionCache::CCSTransitionCache(size_t capacity)
+    :capacity(capacity), hand(0)
+{}
+
+size_t CCSTransitionCache::getCapacity() const
+{ return capacity; }
+
+size_t CCSTransitionCache::size() const
+{ return entries.size(); }
+
+const vector<CCSTransition>* CCSTransitionCache::find(const CCSProcess* p, bool fold, const vector<uint32_t>& seen)
+{
+    size_t* i = index.find({ p, fold });
+    if(!i)
+        return nullptr;
+    Entry& e = entries[*i];
+    for(uint32_t name : seen)
+        if(binary_search(e.names.begin(), e.names.end(), name))
+            return nullptr;
+    e.referenced = true;
+    instantiated.insert(instantiated.end(), e.names.begin(), e.names.end());
+    return &e.trans;
+}
+
+void CCSTransitionCache::start()
+{ instantiated.clear(); }
+
+void CCSTransitionCache::instantiate(uint32_t name)
+{ instantiated.push_back(name); }
+
+size_t CCSTransitionCache::mark() const
+{ return instantiated.size(); }
+
+void CCSTransitionCache::insert(CCSRef<CCSProcess> p, bool fold, size_t mark,
+    vector<CCSTransition>::const_iterator begin, vector<CCSTransition>::const_iterator end)
+{
+    //the names instantiated by p are also instantiated by the processes containing p,
+    //so they are kept (without duplicates) for the enclosing calls
+    sort(instantiated.begin() + mark, instantiated.end());
+    instantiated.erase(unique(instantiated.begin() + mark, instantiated.end()), instantiated.end());
+
+    if(capacity == 0)
+        return;
+
+    size_t i;
+    size_t* existing = index.find({ p.get(), fold });
+    if(existing)
+        i = *existing;
+    else if(entries.size() < capacity)
+    {
+        i = entries.size();
+        entries.emplace_back();
+        index.insert({ p.get(), fold }, i);
+    }
+    else
+    {
+        //advance the clock hand to the first entry that was not used since the hand passed it
+        while(entries[hand].referenced)
+        {
+            entries[hand].referenced = false;
+            hand = (hand + 1) % capacity;
+        }
+        i = hand;
+        hand = (hand + 1) % capacity;
+        index.erase({ entries[i].p.get(), entries[i].fold });
+        index.insert({ p.get(), fold }, i);
+    }
+
+    Entry& e = entries[i];
+    e.p = move(p);
+    e.fold = fold;
+    e.referenced = false;
+    e.trans.assign(begin, end);
+    e.names.assign(instantiated.begin() + mark, instantiated.end());
+}
+
+void CCSTransitionCache::clear()
+{
+    entries.clear();
+    index.clear();
+    hand = 0;
+    instantiated.clear();
+}
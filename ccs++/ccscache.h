@@ -0,0 +1,100 @@
+#ifndef CCSPP_CCSCACHE_H_INCLUDED
+#define CCSPP_CCSCACHE_H_INCLUDED
+
+#include "ccs.h"
+#include "ccshash.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ccspp
+{
+    /** @brief Bounded cache of the transitions of subterms.
+
+        Maps a (hash-consed) process to the transitions computed for it by collectTransitions,
+        i.e. without left hand side and without removing duplicates.
+        When a global state changes only in some of its components, the transitions of the
+        unchanged components are taken from the cache instead of being inferred again.
+
+        The cache holds at most a fixed number of entries and evicts with the CLOCK algorithm:
+        every hit sets the reference bit of the entry, and the clock hand evicts
+        the first entry without reference bit, clearing the bits it passes.
+        The entries keep their processes alive, so the process pointers used as keys stay valid.
+
+        Every entry also records the names of the processes instantiated while computing it,
+        so a cached result is only used if it would not have led to a recursion error on the current path.
+    */
+    class CCSTransitionCache
+    {
+    private:
+        struct Key
+        {
+            const CCSProcess* p;
+            bool fold;
+        };
+
+        struct KeyHash
+        {
+            std::size_t operator() (const Key& k) const
+            { return hash_mix((uintptr_t)k.p ^ k.fold); }
+        };
+
+        struct KeyEq
+        {
+            bool operator() (const Key& k1, const Key& k2) const
+            { return k1.p == k2.p && k1.fold == k2.fold; }
+        };
+
+        struct Entry
+        {
+            CCSRef<CCSProcess> p;
+            bool fold;
+            bool referenced;
+            std::vector<CCSTransition> trans;
+            std::vector<uint32_t> names;
+        };
+
+        std::size_t capacity;
+        std::vector<Entry> entries;
+        CCSHashMap<Key, std::size_t, KeyHash, KeyEq> index;
+        std::size_t hand;
+        std::vector<uint32_t> instantiated;
+
+    public:
+        /** @brief Constructs a cache for at most capacity entries. */
+        CCSTransitionCache(std::size_t capacity);
+
+        /** @brief Returns the maximum number of entries. */
+        std::size_t getCapacity() const;
+
+        /** @brief Returns the number of entries. */
+        std::size_t size() const;
+
+        /** @brief Returns the cached transitions of p, or nullptr if p is not cached
+            or one of the names instantiated by p is in seen.
+            The pointer is invalidated by the next call to insert.
+        */
+        const std::vector<CCSTransition>* find(const CCSProcess* p, bool fold, const std::vector<uint32_t>& seen);
+
+        /** @brief Starts the transition inference of a new state (forgets the recorded instantiations). */
+        void start();
+
+        /** @brief Records the instantiation of a named process (called during transition inference). */
+        void instantiate(uint32_t name);
+
+        /** @brief Returns the number of recorded instantiations, to be passed to insert. */
+        std::size_t mark() const;
+
+        /** @brief Caches the transitions [begin, end) of p, evicting an entry if the cache is full.
+            @param mark The number of recorded instantiations before the transitions of p were computed.
+        */
+        void insert(CCSRef<CCSProcess> p, bool fold, std::size_t mark,
+            std::vector<CCSTransition>::const_iterator begin, std::vector<CCSTransition>::const_iterator end);
+
+        /** @brief Removes all entries. */
+        void clear();
+    };
+}
+
+#endif //CCSPP_CCSCACHE_H_INCLUDED
@@ -0,0 +1,243 @@
+#include "ccsdfs.h"
+#include "ccsbitstate.h"
+#include "ccscache.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+using namespace std;
+using namespace ccspp;
+
+static uint64_t filterBit(const CCSRef<CCSProcess>& p)
+{ return (uint64_t)1 << (p->getHash() & 63); }
+
+const CCSDepthFirstExplorer::Path* CCSDepthFirstExplorer::Path::getParent() const
+{ return parent.get(); }
+
+const CCSTransition& CCSDepthFirstExplorer::Path::getTransition() const
+{ return trans; }
+
+const CCSRef<CCSProcess>& CCSDepthFirstExplorer::Path::getProcess() const
+{ return process; }
+
+size_t CCSDepthFirstExplorer::Path::getLength() const
+{ return length; }
+
+bool CCSDepthFirstExplorer::Path::contains(const CCSRef<CCSProcess>& p) const
+{
+    //the filter has the bits of all states on the path, so most states not on the path are rejected without walking it
+    if(!(filter & filterBit(p)))
+        return false;
+    PtrEq<CCSProcess> eq;
+    for(const Path* path = this; path; path = path->parent.get())
+        if(eq(path->process, p))
+            return true;
+    return false;
+}
+
+vector<CCSTransition> CCSDepthFirstExplorer::Path::getTrace() const
+{
+    vector<CCSTransition> res(length);
+    for(const Path* path = this; path->parent; path = path->parent.get())
+        res[path->length - 1] = path->trans;
+    return res;
+}
+
+vector<uint32_t> CCSDepthFirstExplorer::Path::getOrder() const
+{
+    vector<uint32_t> res(length);
+    for(const Path* path = this; path->parent; path = path->parent.get())
+        res[path->length - 1] = path->index;
+    return res;
+}
+
+
+
+CCSDepthFirstExplorer::CCSDepthFirstExplorer(CCSProgram& program, bool fold, unsigned threads, bool visitOnce)
+    :program(program), fold(fold), threads(max(threads, 1u)), visitOnce(visitOnce), bitstate(nullptr), pending(0), aborted(false), sleepers(0)
+{
+    for(unsigned i = 0; i < this->threads; i++)
+        stacks.emplace_back(new Stack());
+    errors.resize(this->threads);
+
+    //worker 0 is the calling thread and uses the program itself
+    CCSTransitionCache* cache = program.getCache();
+    copies.resize(this->threads - 1, program);
+    for(CCSProgram& copy : copies)
+    {
+        copy.setCacheSize(cache ? cache->getCapacity() : 0);
+        copy.setNormalize(program.getNormalizer() != nullptr);
+    }
+}
+
+unsigned CCSDepthFirstExplorer::getThreads() const
+{ return threads; }
+
+void CCSDepthFirstExplorer::setBitState(CCSBitState* table)
+{ bitstate = table; }
+
+CCSProgram& CCSDepthFirstExplorer::programOf(unsigned worker)
+{ return worker == 0 ? program : copies[worker - 1]; }
+
+shared_ptr<const CCSDepthFirstExplorer::Path> CCSDepthFirstExplorer::take(unsigned worker)
+{
+    shared_ptr<const Path> res;
+    {
+        Stack& own = *stacks[worker];
+        unique_lock<mutex> l(own.lock, defer_lock);
+        if(threads > 1)
+            l.lock();
+        if(!own.paths.empty())
+        {
+            res = move(own.paths.back());
+            own.paths.pop_back();
+            return res;
+        }
+    }
+
+    for(unsigned i = 1; i < threads; i++)
+    {
+        Stack& victim = *stacks[(worker + i) % threads];
+        lock_guard<mutex> l(victim.lock);
+        if(!victim.paths.empty())
+        {
+            res = move(victim.paths.front());
+            victim.paths.pop_front();
+            return res;
+        }
+    }
+    return nullptr;
+}
+
+bool CCSDepthFirstExplorer::claim(const CCSRef<CCSProcess>& p)
+{
+    if(bitstate)
+        return bitstate->insert(p->getHash());
+    Shard& s = shards[p->getHash() >> (64 - shardBits)];
+    lock_guard<mutex> l(s.lock);
+    return s.states.insert(p);
+}
+
+void CCSDepthFirstExplorer::work(unsigned worker, Visitor& v)
+{
+    vector<CCSTransition> trans;
+    try
+    {
+        while(!aborted.load(memory_order_relaxed))
+        {
+            shared_ptr<const Path> path = take(worker);
+            if(!path)
+            {
+                //the search is finished when no path is on a stack or being expanded; otherwise the stacks are checked
+                //again while the lock is held, so a path pushed in between is either found or followed by a wake
+                unique_lock<mutex> l(idleLock);
+                sleepers++;
+                idle.wait(l, [&]()
+                    { return aborted.load() || pending.load(memory_order_acquire) == 0 || (path = take(worker)) != nullptr; });
+                sleepers--;
+                if(!path)
+                    return;
+            }
+
+            bool expand = (!visitOnce || claim(path->process)) && v.enter(*path, worker);
+            if(expand)
+            {
+                try
+                {
+                    path->process->getTransitions(programOf(worker), trans, fold);
+                }
+                catch(CCSException& ex)
+                {
+                    v.error(*path, ex, worker);
+                    expand = false;
+                }
+            }
+            if(expand && v.expand(*path, trans, worker))
+            {
+                //pushed in reverse order, so the first transition is explored first
+                pending.fetch_add(trans.size(), memory_order_relaxed);
+                Stack& own = *stacks[worker];
+                unique_lock<mutex> l(own.lock, defer_lock);
+                if(threads > 1)
+                    l.lock();
+                for(size_t i = trans.size(); i-- > 0;)
+                {
+                    shared_ptr<Path> next = make_shared<Path>();
+                    next->parent = path;
+                    next->trans = trans[i];
+                    next->process = trans[i].getTo();
+                    next->length = path->length + 1;
+                    next->index = i;
+                    next->filter = path->filter | filterBit(next->process);
+                    own.paths.push_back(move(next));
+                }
+                if(l.owns_lock())
+                    l.unlock();
+                //the paths are pushed before sleepers is read, and a sleeper counts itself before it looks at the stacks
+                atomic_thread_fence(memory_order_seq_cst);
+                if(!trans.empty() && sleepers.load() != 0)
+                    wake();
+            }
+            if(pending.fetch_sub(1, memory_order_release) == 1)
+                wake();
+        }
+    }
+    catch(...)
+    {
+        errors[worker] = current_exception();
+        aborted = true;
+        wake();
+    }
+}
+
+void CCSDepthFirstExplorer::wake()
+{
+    if(threads == 1)
+        return;
+    lock_guard<mutex> l(idleLock);
+    idle.notify_all();
+}
+
+void CCSDepthFirstExplorer::explore(Visitor& v, CCSRef<CCSProcess> start)
+{
+    if(!start)
+        start = program.getProcess();
+    for(Shard& s : shards)
+        s.states.clear();
+
+    shared_ptr<Path> root = make_shared<Path>();
+    root->process = start;
+    root->length = 0;
+    root->index = 0;
+    root->filter = filterBit(start);
+    stacks[0]->paths.push_back(move(root));
+    pending = 1;
+    aborted = false;
+    sleepers = 0;
+
+    if(threads == 1)
+        work(0, v);
+    else
+    {
+        bool wasAtomic = CCSRefCounted::isAtomic();
+        CCSRefCounted::setAtomic(true);
+        vector<thread> workers;
+        for(unsigned i = 1; i < threads; i++)
+            workers.emplace_back(&CCSDepthFirstExplorer::work, this, i, ref(v));
+        work(0, v);
+        for(thread& t : workers)
+            t.join();
+        CCSRefCounted::setAtomic(wasAtomic);
+    }
+
+    for(unique_ptr<Stack>& s : stacks)
+        s->paths.clear();
+    for(exception_ptr& error : errors)
+        if(error)
+        {
+            exception_ptr e = error;
+            for(exception_ptr& other : errors)
+                other = nullptr;
+            rethrow_exception(e);
+        }
+}
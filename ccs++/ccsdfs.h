@@ -0,0 +1,162 @@
+#ifndef CCSPP_CCSDFS_H_INCLUDED
+#define CCSPP_CCSDFS_H_INCLUDED
+
+#include "ccs.h"
+#include "ccshash.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ccspp
+{
+    class CCSBitState;
+
+    /** @brief Depth-first exploration of the LTS of a program on several threads with work stealing.
+
+        The search tree consists of paths from the initial state. Every worker keeps its own stack of unexplored paths,
+        takes the newest path from it and pushes the extensions of the path by the transitions of its last state,
+        so a single worker explores the tree in depth-first order. An idle worker steals the oldest path
+        from the stack of another worker, i.e. the largest unexplored subtree. If all stacks are empty,
+        it sleeps until a path is pushed or the search is finished.
+
+        Paths share their prefixes, so a stolen path carries the states on it, and analyses depending on the
+        current path (like cycle checks) work on every thread. getOrder of a path gives its position in a
+        sequential depth-first search, so analyses can report their results in a deterministic order.
+        Optionally, every state is only expanded once, using a visited table shared by all workers
+        or a bit-state table (see setBitState).
+
+        Every worker uses its own copy of the program (see CCSExplorer).
+    */
+    class CCSDepthFirstExplorer
+    {
+    public:
+        /** @brief A path from the initial state in the search tree. */
+        class Path
+        {
+            friend class CCSDepthFirstExplorer;
+
+        private:
+            std::shared_ptr<const Path> parent;
+            CCSTransition trans;
+            CCSRef<CCSProcess> process;
+            std::size_t length;
+            uint32_t index;
+            uint64_t filter;
+
+        public:
+            /** @brief Returns the path without its last transition, or nullptr for the initial state. */
+            const Path* getParent() const;
+
+            /** @brief Returns the last transition of the path (an empty transition for the initial state). */
+            const CCSTransition& getTransition() const;
+
+            /** @brief Returns the last state of the path. */
+            const CCSRef<CCSProcess>& getProcess() const;
+
+            /** @brief Returns the number of transitions of the path. */
+            std::size_t getLength() const;
+
+            /** @brief Returns true if p is a state of the path. */
+            bool contains(const CCSRef<CCSProcess>& p) const;
+
+            /** @brief Returns the transitions of the path. */
+            std::vector<CCSTransition> getTrace() const;
+
+            /** @brief Returns the indices of the transitions of the path among the (sorted) transitions of their sources.
+                Comparing them lexicographically gives the order of a sequential depth-first search.
+            */
+            std::vector<uint32_t> getOrder() const;
+        };
+
+        /** @brief Callbacks of the search. They are called on the worker threads, possibly at the same time. */
+        class Visitor
+        {
+        public:
+            virtual ~Visitor() {}
+
+            /** @brief Called when a path is taken from a stack.
+                @returns false if the last state of the path should not be expanded.
+            */
+            virtual bool enter(const Path& path, unsigned worker) = 0;
+
+            /** @brief Called with the transitions of the last state of a path.
+                @returns false if the path should not be extended by the transitions.
+            */
+            virtual bool expand(const Path& path, const std::vector<CCSTransition>& trans, unsigned worker) = 0;
+
+            /** @brief Called if the transition inference of the last state of a path throws a CCSException
+                (from within the handler, so `throw;` rethrows the original exception).
+            */
+            virtual void error(const Path& path, const CCSException& ex, unsigned worker) = 0;
+        };
+
+    private:
+        static const std::size_t shardBits = 6;
+
+        struct Stack
+        {
+            std::mutex lock;
+            std::deque<std::shared_ptr<const Path>> paths;
+        };
+
+        struct Shard
+        {
+            std::mutex lock;
+            CCSHashSet<CCSRef<CCSProcess>, PtrHash<CCSProcess>, PtrEq<CCSProcess>> states;
+        };
+
+        CCSProgram& program;
+        bool fold;
+        unsigned threads;
+        bool visitOnce;
+        CCSBitState* bitstate;
+        std::vector<CCSProgram> copies;
+        std::vector<std::unique_ptr<Stack>> stacks;
+        Shard shards[1 << shardBits];
+        std::atomic<std::size_t> pending;
+        std::atomic<bool> aborted;
+        //idle workers wait for new paths or the end of the search
+        std::mutex idleLock;
+        std::condition_variable idle;
+        std::atomic<unsigned> sleepers;
+        std::vector<std::exception_ptr> errors;
+
+        CCSProgram& programOf(unsigned worker);
+        std::shared_ptr<const Path> take(unsigned worker);
+        bool claim(const CCSRef<CCSProcess>& p);
+        void work(unsigned worker, Visitor& v);
+        void wake();
+
+    public:
+        /** @brief Constructs an explorer.
+            @param fold True if constant expression should be folded to constants.
+            @param threads The number of threads (at least 1).
+            @param visitOnce True if every state should only be expanded on the first path reaching it.
+        */
+        CCSDepthFirstExplorer(CCSProgram& program, bool fold = true, unsigned threads = 1, bool visitOnce = false);
+
+        CCSDepthFirstExplorer(const CCSDepthFirstExplorer&) = delete;
+        CCSDepthFirstExplorer& operator= (const CCSDepthFirstExplorer&) = delete;
+
+        /** @brief Returns the number of threads. */
+        unsigned getThreads() const;
+
+        /** @brief Sets the bit-state table used instead of the visited table if every state is only expanded once
+            (nullptr to use the visited table again). The table is not cleared by explore.
+        */
+        void setBitState(CCSBitState* table);
+
+        /** @brief Searches from start (the main process of the program if nullptr) until all paths are explored.
+            Exceptions thrown by the visitor stop the search and are rethrown.
+        */
+        void explore(Visitor& v, CCSRef<CCSProcess> start = nullptr);
+    };
+}
+
+#endif //CCSPP_CCSDFS_H_INCLUDED
@@ -1,19 +1,57 @@
 #include "ccs.h"
 #include "ccsvisitor.h"
+#include "ccsunique.h"
 #include <sstream>
 
 using namespace std;
 using namespace ccspp;
 
 CCSExp::CCSExp(Type type)
-    :type(type)
+    :type(type), hash(hash_mix(type + 1)), vars(0), interned(false), foldable(false)
 {}
 
+CCSExp::~CCSExp()
+{
+    if(interned)
+        uniqueTable().erase(this);
+}
+
+CCSUniqueTable<CCSExp>& CCSExp::uniqueTable()
+{
+    //never destroyed, expressions may outlive static destruction
+    static CCSUniqueTable<CCSExp>* table = new CCSUniqueTable<CCSExp>();
+    return *table;
+}
+
+CCSRef<CCSExp> CCSExp::unique(CCSRef<CCSExp> e)
+{ return uniqueTable().intern(e); }
+
+uint64_t CCSExp::getHash() const
+{ return hash; }
+
 CCSExp::Type CCSExp::getType() const
 { return type; }
 
+uint64_t CCSExp::getVars() const
+{ return vars; }
+
+bool CCSExp::isFoldable() const
+{ return foldable; }
+
+CCSRef<CCSExp> CCSExp::subst(string id, int val, bool fold)
+{ return subst(CCSEnv({ CCSSymbols::intern(id) }, { val }), fold); }
+
+CCSRef<CCSExp> CCSExp::subst(const CCSEnv& env, bool fold)
+{
+    if(!(vars & env.getMask()) && !(fold && foldable))
+        return self();
+    return substitute(env, fold);
+}
+
 int CCSExp::compare(CCSExp& p) const
 {
+    if(this == &p)
+        return 0;
     if(type < p.type)
         return -1;
     else if(type > p.type)
@@ -42,7 +80,9 @@ ostream& ccspp::operator<< (ostream& out, const CCSExp& p)
 
 CCSConstExp::CCSConstExp(int val)
     :CCSExp(CONST), val(val)
-{}
+{
+    hash = hash_combine(hash, (uint64_t)val);
+}
 
 int CCSConstExp::getVal() const
 { return val; }
@@ -58,9 +98,9 @@ int CCSConstExp::compare(CCSExp* e) const
         return 1;
 }
 
-shared_ptr<CCSExp> CCSConstExp::subst(string id, int val, bool fold)
+CCSRef<CCSExp> CCSConstExp::substitute(const CCSEnv& env, bool fold)
 {
-    return shared_from_this();
+    return self();
 }
 
 int CCSConstExp::eval()
@@ -79,8 +119,11 @@ void CCSConstExp::accept(CCSExpVisitor<void>* v)
 
 
 CCSIdExp::CCSIdExp(string id)
-    :CCSExp(ID), id(id)
-{}
+    :CCSExp(ID), id(id), sym(CCSSymbols::intern(id))
+{
+    hash = hash_combine(hash, hash_string(id));
+    vars = CCSEnv::idMask(sym);
+}
 
 string CCSIdExp::getId() const
 { return id; }
@@ -96,12 +139,13 @@ int CCSIdExp::compare(CCSExp* e) const
         return 1;
 }
 
-shared_ptr<CCSExp> CCSIdExp::subst(string id, int val, bool fold)
+CCSRef<CCSExp> CCSIdExp::substitute(const CCSEnv& env, bool fold)
 {
-    if(this->id == id)
-        return make_shared<CCSConstExp>(val);
+    const int* val = env.find(sym);
+    if(val)
+        return make_exp<CCSConstExp>(*val);
     else
-        return shared_from_this();
+        return self();
 }
 
 int CCSIdExp::eval()
@@ -111,7 +155,7 @@ int CCSIdExp::eval()
     else if(id == "false")
         return 0;
     else
-        throw CCSUnboundException(shared_from_this(), id, "unbound identifier: " + id);
+        throw CCSUnboundException(self(), id, "unbound identifier: " + id);
 }
 
 void CCSIdExp::print(ostream& out) const
@@ -124,14 +168,18 @@ void CCSIdExp::accept(CCSExpVisitor<void>* v)
 
 
 
-CCSUnaryExp::CCSUnaryExp(Op op, shared_ptr<CCSExp> exp)
+CCSUnaryExp::CCSUnaryExp(Op op, CCSRef<CCSExp> exp)
     :CCSExp(UNARY), op(op), exp(exp)
-{}
+{
+    hash = hash_combine(hash_combine(hash, op), exp->hash);
+    vars = exp->vars;
+    foldable = exp->foldable || exp->type == CONST;
+}
 
 CCSUnaryExp::Op CCSUnaryExp::getOp() const
 { return op; }
 
-shared_ptr<CCSExp> CCSUnaryExp::getExp() const
+CCSRef<CCSExp> CCSUnaryExp::getExp() const
 { return exp; }
 
 int CCSUnaryExp::compare(CCSExp* e) const
@@ -144,15 +192,15 @@ int CCSUnaryExp::compare(CCSExp* e) const
     return exp->compare(*_e->exp);
 }
 
-shared_ptr<CCSExp> CCSUnaryExp::subst(string id, int val, bool fold)
+CCSRef<CCSExp> CCSUnaryExp::substitute(const CCSEnv& env, bool fold)
 {
-    shared_ptr<CCSExp> exp2 = exp->subst(id, val, fold);
+    CCSRef<CCSExp> exp2 = exp->subst(env, fold);
     if(fold && exp2->getType() == CCSExp::CONST)
-        return make_shared<CCSConstExp>(eval(exp2->eval()));
+        return make_exp<CCSConstExp>(eval(exp2->eval()));
     if(exp2 == exp)
-        return shared_from_this();
+        return self();
     else
-        return make_shared<CCSUnaryExp>(op, exp2);
+        return make_exp<CCSUnaryExp>(op, exp2);
 }
 
 int CCSUnaryExp::eval(int val)
@@ -163,7 +211,7 @@ int CCSUnaryExp::eval(int val)
     case MINUS: return -val;
     case NOT: return !val;
     }
-    throw CCSExpException(shared_from_this(), "this should not happen");
+    throw CCSExpException(self(), "this should not happen");
 }
 
 int CCSUnaryExp::eval()
@@ -175,7 +223,7 @@ int CCSUnaryExp::eval()
     }
     catch(CCSExpException& e)
     {
-        e.setExp(shared_from_this());
+        e.setExp(self());
         throw;
     }
     return eval(val);
@@ -199,17 +247,21 @@ void CCSUnaryExp::accept(CCSExpVisitor<void>* v)
 
 
 
-CCSBinaryExp::CCSBinaryExp(Op op, shared_ptr<CCSExp> lhs, shared_ptr<CCSExp> rhs)
+CCSBinaryExp::CCSBinaryExp(Op op, CCSRef<CCSExp> lhs, CCSRef<CCSExp> rhs)
     :CCSExp(BINARY), op(op), lhs(lhs), rhs(rhs)
-{}
+{
+    hash = hash_combine(hash_combine(hash_combine(hash, op), lhs->hash), rhs->hash);
+    vars = lhs->vars | rhs->vars;
+    foldable = lhs->foldable || rhs->foldable || (lhs->type == CONST && rhs->type == CONST);
+}
 
 CCSBinaryExp::Op CCSBinaryExp::getOp() const
 { return op; }
 
-shared_ptr<CCSExp> CCSBinaryExp::getLhs() const
+CCSRef<CCSExp> CCSBinaryExp::getLhs() const
 { return lhs; }
 
-shared_ptr<CCSExp> CCSBinaryExp::getRhs() const
+CCSRef<CCSExp> CCSBinaryExp::getRhs() const
 { return rhs; }
 
 int CCSBinaryExp::compare(CCSExp* e) const
@@ -226,16 +278,16 @@ int CCSBinaryExp::compare(CCSExp* e) const
 }
 
 
-shared_ptr<CCSExp> CCSBinaryExp::subst(string id, int val, bool fold)
+CCSRef<CCSExp> CCSBinaryExp::substitute(const CCSEnv& env, bool fold)
 {
-    shared_ptr<CCSExp> lhs2 = lhs->subst(id, val, fold);
-    shared_ptr<CCSExp> rhs2 = rhs->subst(id, val, fold);
+    CCSRef<CCSExp> lhs2 = lhs->subst(env, fold);
+    CCSRef<CCSExp> rhs2 = rhs->subst(env, fold);
     if(fold && lhs2->getType() == CCSExp::CONST && rhs2->getType() == CCSExp::CONST)
-        return make_shared<CCSConstExp>(eval(lhs2->eval(), rhs2->eval()));
+        return make_exp<CCSConstExp>(eval(lhs2->eval(), rhs2->eval()));
     if(lhs2 == lhs && rhs2 == rhs)
-        return shared_from_this();
+        return self();
     else
-        return make_shared<CCSBinaryExp>(op, lhs2, rhs2);
+        return make_exp<CCSBinaryExp>(op, lhs2, rhs2);
 }
 
 int CCSBinaryExp::eval(int lval, int rval)
@@ -247,11 +299,11 @@ int CCSBinaryExp::eval(int lval, int rval)
     case MUL: return lval * rval;
     case DIV:
         if(rval == 0)
-            throw CCSUndefinedException(shared_from_this(), "division by zero");
+            throw CCSUndefinedException(self(), "division by zero");
         return lval / rval;
     case MOD:
         if(rval == 0)
-            throw CCSUndefinedException(shared_from_this(), "division by zero");
+            throw CCSUndefinedException(self(), "division by zero");
         return lval % rval;
     case OR: return lval || rval;
     case AND: return lval && rval;
@@ -262,7 +314,7 @@ int CCSBinaryExp::eval(int lval, int rval)
     case GT: return lval > rval;
     case GEQ: return lval >= rval;
     }
-    throw CCSExpException(shared_from_this(), "this should not happen");
+    throw CCSExpException(self(), "this should not happen");
 }
 
 int CCSBinaryExp::eval()
@@ -276,7 +328,7 @@ int CCSBinaryExp::eval()
     }
     catch(CCSExpException& e)
     {
-        e.setExp(shared_from_this());
+        e.setExp(self());
         throw;
     }
     return eval(lval, rval);
@@ -1,6 +1,7 @@
 #ifndef CCSPP_CCSEXP_H_INCLUDED
 #define CCSPP_CCSEXP_H_INCLUDED
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <set>
@@ -10,7 +11,7 @@
 namespace ccspp
 {
     /** @brief Represents a CCS expression used in CCSvp. */
-    class CCSExp
+    class CCSExp : public CCSRefCounted
     {
     public:
         /** @brief The type of the CCS expression */
@@ -26,9 +27,16 @@ namespace ccspp
         friend class CCSIdExp;
         friend class CCSUnaryExp;
         friend class CCSBinaryExp;
+        friend class CCSUniqueTable<CCSExp>;
 
     private:
         Type type;
+        uint64_t hash;
+        uint64_t vars;
+        bool interned;
+        bool foldable;
+
+        static CCSUniqueTable<CCSExp>& uniqueTable();
 
     protected:
         /** @brief Internal comparison function.
@@ -36,18 +44,48 @@ namespace ccspp
         */
         virtual int compare(CCSExp* e) const = 0;
 
+        /** @brief Returns a reference to this expression (which is owned by other references). */
+        CCSRef<CCSExp> self()
+        { return CCSRef<CCSExp>(this); }
+
+        /** @brief Internal substitution method.
+            Only called by subst if the expression is affected by the substitution.
+        */
+        virtual CCSRef<CCSExp> substitute(const CCSEnv& env, bool fold) = 0;
+
     public:
         /** @brief Constructor. */
         CCSExp(Type type);
 
         /** @brief Destructor. */
-        virtual ~CCSExp() = default;
+        virtual ~CCSExp();
+
+        /** @brief Returns the canonical instance of an expression.
+            All expressions should be created with make_exp, which calls this method,
+            so structurally equal expressions are represented by the same object.
+        */
+        static CCSRef<CCSExp> unique(CCSRef<CCSExp> e);
+
+        /** @brief Returns the structural hash (computed once at construction). */
+        uint64_t getHash() const;
 
         /** @brief Returns the type of the expression. */
         Type getType() const;
 
+        /** @brief Returns the mask of the identifiers in the expression (see CCSEnv). */
+        uint64_t getVars() const;
+
+        /** @brief Returns true if substitution with folding would fold a constant subexpression. */
+        bool isFoldable() const;
+
         /** @brief Substitute identifier by a value. */
-        virtual std::shared_ptr<CCSExp> subst(std::string id, int val, bool fold = true) = 0;
+        CCSRef<CCSExp> subst(std::string id, int val, bool fold = true);
+
+        /** @brief Substitutes all identifiers bound in env by their values in one pass.
+            Returns this expression without traversing it if it contains none of the identifiers
+            and there is nothing to fold.
+        */
+        CCSRef<CCSExp> subst(const CCSEnv& env, bool fold = true);
 
         /** @brief Evaluates the expression.
             @throws CCSUnboundException if there is an identifier in the expression.
@@ -73,47 +111,56 @@ namespace ccspp
         bool operator< (CCSExp& e) const;
     };
 
+    /** @brief Creates a hash-consed expression.
+        Use this instead of new, so equal expressions are the same object.
+        The expression is allocated from the current CCSMemoryResource.
+    */
+    template<typename T, typename... Args>
+    CCSRef<T> make_exp(Args&&... args)
+    { return static_ref_cast<T>(CCSExp::unique(CCSRef<CCSExp>(new T(std::forward<Args>(args)...)))); }
+
     /** @brief Prints a CCSExp to an output stream */
     std::ostream& operator<< (std::ostream& out, const CCSExp& p);
 
     /** @brief Represents a constant. */
-    class CCSConstExp : public CCSExp, public std::enable_shared_from_this<CCSConstExp>
+    class CCSConstExp : public CCSExp
     {
     private:
         int val;
 
     protected:
         virtual int compare(CCSExp* e) const;
+        virtual CCSRef<CCSExp> substitute(const CCSEnv& env, bool fold);
 
     public:
         CCSConstExp(int val);
         int getVal() const;
-        virtual std::shared_ptr<CCSExp> subst(std::string id, int val, bool fold = true);
         virtual int eval();
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSExpVisitor<void>* v);
     };
 
     /** @brief Represents an identifier. */
-    class CCSIdExp : public CCSExp, public std::enable_shared_from_this<CCSIdExp>
+    class CCSIdExp : public CCSExp
     {
     private:
         std::string id;
+        uint32_t sym;
 
     protected:
         virtual int compare(CCSExp* e) const;
+        virtual CCSRef<CCSExp> substitute(const CCSEnv& env, bool fold);
 
     public:
         CCSIdExp(std::string id);
         std::string getId() const;
-        virtual std::shared_ptr<CCSExp> subst(std::string id, int val, bool fold = true);
         virtual int eval();
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSExpVisitor<void>* v);
     };
 
     /** @brief Represents a unary expression. */
-    class CCSUnaryExp : public CCSExp, public std::enable_shared_from_this<CCSUnaryExp>
+    class CCSUnaryExp : public CCSExp
     {
     public:
         enum Op
@@ -124,25 +171,25 @@ namespace ccspp
         };
     private:
         Op op;
-        std::shared_ptr<CCSExp> exp;
+        CCSRef<CCSExp> exp;
 
         int eval(int val);
 
     protected:
         virtual int compare(CCSExp* e) const;
+        virtual CCSRef<CCSExp> substitute(const CCSEnv& env, bool fold);
 
     public:
-        CCSUnaryExp(Op op, std::shared_ptr<CCSExp> exp);
+        CCSUnaryExp(Op op, CCSRef<CCSExp> exp);
         Op getOp() const;
-        std::shared_ptr<CCSExp> getExp() const;
-        virtual std::shared_ptr<CCSExp> subst(std::string id, int val, bool fold = true);
+        CCSRef<CCSExp> getExp() const;
         virtual int eval();
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSExpVisitor<void>* v);
     };
 
     /** @brief Represents a binary expression. */
-    class CCSBinaryExp : public CCSExp, public std::enable_shared_from_this<CCSBinaryExp>
+    class CCSBinaryExp : public CCSExp
     {
     public:
         enum Op
@@ -163,20 +210,20 @@ namespace ccspp
         };
     private:
         Op op;
-        std::shared_ptr<CCSExp> lhs;
-        std::shared_ptr<CCSExp> rhs;
+        CCSRef<CCSExp> lhs;
+        CCSRef<CCSExp> rhs;
 
         int eval(int lval, int rval);
 
     protected:
         virtual int compare(CCSExp* e) const;
+        virtual CCSRef<CCSExp> substitute(const CCSEnv& env, bool fold);
 
     public:
-        CCSBinaryExp(Op op, std::shared_ptr<CCSExp> lhs, std::shared_ptr<CCSExp> rhs);
+        CCSBinaryExp(Op op, CCSRef<CCSExp> lhs, CCSRef<CCSExp> rhs);
         Op getOp() const;
-        std::shared_ptr<CCSExp> getLhs() const;
-        std::shared_ptr<CCSExp> getRhs() const;
-        virtual std::shared_ptr<CCSExp> subst(std::string id, int val, bool fold = true);
+        CCSRef<CCSExp> getLhs() const;
+        CCSRef<CCSExp> getRhs() const;
         virtual int eval();
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSExpVisitor<void>* v);
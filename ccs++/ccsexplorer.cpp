@@ -0,0 +1,371 @@
+#include "ccsexplorer.h"
+#include "ccscache.h"
+#include "ccslts.h"
+#include <algorithm>
+
+using namespace std;
+using namespace ccspp;
+
+CCSExplorer::CCSExplorer(CCSProgram& program, bool fold, unsigned threads, bool compact)
+    :program(program), fold(fold), compact(compact), budget(nullptr), frontierId(0), wasAtomic(CCSRefCounted::isAtomic()),
+     task(nullptr), generation(0), running(0), stopping(false)
+{
+    if(threads < 1)
+        threads = 1;
+    discovered.resize(threads);
+    errors.resize(threads);
+    if(threads == 1)
+        return;
+
+    //worker 0 is the calling thread and uses the program itself
+    CCSTransitionCache* cache = program.getCache();
+    copies.resize(threads - 1, program);
+    for(CCSProgram& copy : copies)
+    {
+        copy.setCacheSize(cache ? cache->getCapacity() : 0);
+        copy.setNormalize(program.getNormalizer() != nullptr);
+    }
+
+    CCSRefCounted::setAtomic(true);
+    for(unsigned i = 1; i < threads; i++)
+        workers.emplace_back(&CCSExplorer::work, this, i);
+}
+
+CCSExplorer::~CCSExplorer()
+{
+    {
+        lock_guard<mutex> l(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(thread& t : workers)
+        t.join();
+    CCSRefCounted::setAtomic(wasAtomic);
+}
+
+unsigned CCSExplorer::getThreads() const
+{ return workers.size() + 1; }
+
+void CCSExplorer::setBudget(CCSBudget* budget)
+{ this->budget = budget; }
+
+CCSExplorer::Shard& CCSExplorer::shard(const CCSRef<CCSProcess>& p)
+{ return shards[p->getHash() >> (64 - shardBits)]; }
+
+pair<CCSExplorer::Entry*, bool> CCSExplorer::insert(Shard& s, const CCSRef<CCSProcess>& p, Entry e)
+{
+    if(compact)
+        return s.fingerprints.insert(p->getHash(), e);
+    else
+        return s.states.insert(p, e);
+}
+
+CCSExplorer::Entry* CCSExplorer::find(const CCSRef<CCSProcess>& p)
+{
+    if(compact)
+        return shard(p).fingerprints.find(p->getHash());
+    else
+        return shard(p).states.find(p);
+}
+
+CCSProgram& CCSExplorer::programOf(unsigned worker)
+{ return worker == 0 ? program : copies[worker - 1]; }
+
+void CCSExplorer::work(unsigned worker)
+{
+    uint64_t seen = 0;
+    for(;;)
+    {
+        {
+            unique_lock<mutex> l(lock);
+            wake.wait(l, [&]{ return stopping || generation != seen; });
+            if(stopping)
+                return;
+            seen = generation;
+        }
+        runTask(worker);
+        {
+            lock_guard<mutex> l(lock);
+            if(--running == 0)
+                done.notify_one();
+        }
+    }
+}
+
+void CCSExplorer::runTask(unsigned worker)
+{
+    try
+    {
+        (*task)(worker);
+    }
+    catch(...)
+    {
+        errors[worker] = current_exception();
+    }
+}
+
+void CCSExplorer::runParallel(const function<void(unsigned)>& f)
+{
+    task = &f;
+    if(!workers.empty())
+    {
+        lock_guard<mutex> l(lock);
+        running = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+    runTask(0);
+    if(!workers.empty())
+    {
+        unique_lock<mutex> l(lock);
+        done.wait(l, [&]{ return running == 0; });
+    }
+    task = nullptr;
+
+    for(exception_ptr& error : errors)
+        if(error)
+        {
+            exception_ptr e = error;
+            for(exception_ptr& other : errors)
+                other = nullptr;
+            rethrow_exception(e);
+        }
+}
+
+void CCSExplorer::forEach(size_t n, size_t chunk, const function<void(size_t, unsigned)>& f)
+{
+    atomic<size_t> next(0);
+    runParallel([&](unsigned worker)
+    {
+        for(;;)
+        {
+            size_t begin = next.fetch_add(chunk, memory_order_relaxed);
+            if(begin >= n)
+                return;
+            size_t end = min(begin + chunk, n);
+            for(size_t i = begin; i < end; i++)
+                f(i, worker);
+        }
+    });
+}
+
+void CCSExplorer::expandLayer()
+{
+    //the states are reused from the previous layer, so their buffers keep their capacity
+    if(layer.size() < frontier.size())
+        layer.resize(frontier.size());
+
+    //compute the transitions and insert their targets, remembering the smallest key of every new state;
+    //a single thread discovers the states in BFS order, so it numbers them right away
+    size_t nextId = frontierId + frontier.size();
+    size_t sequentialId = nextId;
+    forEach(frontier.size(), 16, [&](size_t i, unsigned worker)
+    {
+        State& s = layer[i];
+        s.id = frontierId + i;
+        s.process = frontier[i];
+        s.error = false;
+        s.message.clear();
+        try
+        {
+            s.process->getTransitions(programOf(worker), s.trans, fold);
+        }
+        catch(CCSException& ex)
+        {
+            s.error = true;
+            s.message = ex.what();
+        }
+
+        s.targets.resize(s.trans.size());
+        for(size_t j = 0; j < s.trans.size(); j++)
+        {
+            const CCSRef<CCSProcess>& to = s.trans[j].getTo();
+            uint64_t key = ((uint64_t)i << 32) | j;
+            Shard& sh = shard(to);
+            unique_lock<mutex> l(sh.lock, defer_lock);
+            if(!workers.empty())
+                l.lock();
+            pair<Entry*, bool> ins = insert(sh, to, { workers.empty() ? sequentialId : npos, key });
+            if(ins.second)
+            {
+                discovered[worker].push_back({ key, to });
+                if(workers.empty())
+                    sequentialId++;
+            }
+            else if(ins.first->id == npos && key < ins.first->key)
+                ins.first->key = key;
+            s.targets[j] = ins.first->id;
+            if(compact && workers.empty())
+                s.trans[j] = CCSTransition(s.trans[j].getAction(), s.process, nullptr);
+        }
+        //the transitions are collected before restricted ones are removed, so the buffer is usually much larger than needed
+        if(compact)
+            s.trans.shrink_to_fit();
+    });
+
+    if(workers.empty())
+    {
+        frontierId = nextId;
+        frontier.clear();
+        for(Discovery& d : discovered[0])
+            frontier.push_back(move(d.process));
+        discovered[0].clear();
+        return;
+    }
+
+    //the keys in the discovery lists may have been lowered by other workers in the meantime;
+    //the table is not modified any more, so it can be read without locks
+    runParallel([&](unsigned worker)
+    {
+        for(Discovery& d : discovered[worker])
+            d.key = find(d.process)->key;
+    });
+
+    vector<Discovery> next;
+    for(vector<Discovery>& d : discovered)
+    {
+        next.insert(next.end(), make_move_iterator(d.begin()), make_move_iterator(d.end()));
+        d.clear();
+    }
+    sort(next.begin(), next.end(), [](const Discovery& d1, const Discovery& d2)
+        { return d1.key < d2.key; });
+
+    forEach(next.size(), 256, [&](size_t k, unsigned worker)
+    {
+        find(next[k].process)->id = nextId + k;
+    });
+    forEach(frontier.size(), 64, [&](size_t i, unsigned worker)
+    {
+        State& s = layer[i];
+        for(size_t j = 0; j < s.trans.size(); j++)
+        {
+            if(s.targets[j] == npos)
+            {
+                const CCSRef<CCSProcess>& to = s.trans[j].getTo();
+                s.targets[j] = find(to)->id;
+            }
+            if(compact)
+                s.trans[j] = CCSTransition(s.trans[j].getAction(), s.process, nullptr);
+        }
+    });
+
+    frontierId = nextId;
+    frontier.clear();
+    for(Discovery& d : next)
+        frontier.push_back(move(d.process));
+}
+
+bool CCSExplorer::explore(int maxDepth, const Visitor& visit)
+{
+    CCSRef<CCSProcess> start = program.getProcess();
+    insert(shard(start), start, { 0, 0 });
+    frontier = { start };
+    frontierId = 0;
+
+    for(int depth = 0; (maxDepth < 0 || depth < maxDepth) && !frontier.empty(); depth++)
+    {
+        //the ids are consecutive, so the discovered states are counted without looking at the table
+        if(budget && budget->exceeded(frontierId + frontier.size()))
+            break;
+        size_t n = frontier.size();
+        expandLayer();
+        for(size_t i = 0; i < n; i++)
+            if(!visit(layer[i]))
+                return false;
+    }
+    return true;
+}
+
+bool CCSExplorer::explore(int maxDepth, const vector<Observer*>& observers)
+{
+    CCSRef<CCSProcess> start = program.getProcess();
+    for(Observer* o : observers)
+        o->discovered(0, start, nullptr, 0);
+
+    size_t discoveredId = 1;
+    size_t stopId = npos;
+    bool completed = explore(maxDepth, [&](const State& s)
+    {
+        if(budget && budget->exceeded(discoveredId))
+        {
+            stopId = s.id;
+            return false;
+        }
+        for(Observer* o : observers)
+            o->state(s);
+        if(s.error)
+        {
+            for(Observer* o : observers)
+                if(!o->error(s))
+                    return false;
+        }
+        else if(s.trans.empty())
+            for(Observer* o : observers)
+                o->deadlock(s);
+
+        for(size_t i = 0; i < s.trans.size(); i++)
+        {
+            for(Observer* o : observers)
+                o->transition(s, i);
+            //states are numbered in the order of their discovery, so a target is new iff it has the next id
+            if(s.targets[i] == discoveredId)
+            {
+                discoveredId++;
+                //the targets may have been dropped (hash compaction), but the new states are in the next layer
+                const CCSRef<CCSProcess>& to = frontier[s.targets[i] - frontierId];
+                for(Observer* o : observers)
+                    o->discovered(s.targets[i], to, &s, i);
+            }
+        }
+        return true;
+    });
+    if(!completed && stopId == npos)
+        return false;
+
+    if(stopId != npos)
+    {
+        //the budget stopped the exploration within a layer: the rest of the layer is unexplored,
+        //and of the next layer only the states discovered by the explored states were reported
+        for(size_t id = stopId; id < frontierId; id++)
+            for(Observer* o : observers)
+                o->unexplored(id, layer[id - layer[0].id].process);
+        for(size_t id = frontierId; id < discoveredId; id++)
+            for(Observer* o : observers)
+                o->unexplored(id, frontier[id - frontierId]);
+    }
+    else
+        for(const CCSRef<CCSProcess>& p : frontier)
+        {
+            size_t id = getId(p);
+            for(Observer* o : observers)
+                o->unexplored(id, p);
+        }
+    for(Observer* o : observers)
+        o->finished();
+    return true;
+}
+
+bool CCSExplorer::explore(int maxDepth, CCSLTS& lts, const vector<Observer*>& observers)
+{
+    CCSLTS::Builder builder(lts);
+    vector<Observer*> all{ &builder };
+    all.insert(all.end(), observers.begin(), observers.end());
+    return explore(maxDepth, all);
+}
+
+const vector<CCSRef<CCSProcess>>& CCSExplorer::getFrontier() const
+{ return frontier; }
+
+size_t CCSExplorer::getId(const CCSRef<CCSProcess>& p)
+{
+    Entry* e = find(p);
+    return e ? e->id : npos;
+}
+
+size_t CCSExplorer::size()
+{
+    size_t res = 0;
+    for(Shard& s : shards)
+        res += s.states.size() + s.fingerprints.size();
+    return res;
+}
@@ -0,0 +1,225 @@
+#ifndef CCSPP_CCSEXPLORER_H_INCLUDED
+#define CCSPP_CCSEXPLORER_H_INCLUDED
+
+#include "ccs.h"
+#include "ccsbudget.h"
+#include "ccshash.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ccspp
+{
+    class CCSLTS;
+
+    /** @brief Breadth-first exploration of the LTS of a program on several threads.
+
+        The states are explored layer by layer. The transitions of the states of a layer are computed in parallel,
+        and their targets are inserted into a visited table that is split into shards with a lock each.
+        A state discovered in a layer is numbered after the layer in the order of its first discovery,
+        i.e. by the smallest pair (index of the predecessor in the layer, index of the transition).
+        This is the order of a sequential breadth-first search, so the ids of the states
+        and the order in which they are visited do not depend on the number of threads.
+
+        Every worker thread uses its own copy of the program, so the transition cache (see CCSProgram::setCacheSize)
+        and the memoized instances need no locks. While more than one thread is used, reference counts are atomic
+        (see CCSRefCounted::setAtomic).
+    */
+    class CCSExplorer
+    {
+    public:
+        /** @brief An explored state, passed to the visitor of explore. */
+        struct State
+        {
+            /** @brief The id of the state (0 is the initial state, the others are numbered in BFS order). */
+            std::size_t id;
+
+            /** @brief The process of the state. */
+            CCSRef<CCSProcess> process;
+
+            /** @brief The transitions of the state (sorted, empty if there was an error).
+                The targets may be nullptr (see CCSProductExplorer and hash compaction), their ids are in targets.
+            */
+            std::vector<CCSTransition> trans;
+
+            /** @brief The ids of the targets of the transitions. */
+            std::vector<std::size_t> targets;
+
+            /** @brief True if the transition inference of the state threw a CCSException. */
+            bool error;
+
+            /** @brief The message of the exception if error is true. */
+            std::string message;
+        };
+
+        /** @brief The visitor of explore. Returns false to stop the exploration. */
+        typedef std::function<bool(const State&)> Visitor;
+
+        /** @brief Observer of an exploration, so several analyses can share one exploration.
+
+            All methods are called on the thread calling explore, in BFS order:
+            for every explored state state is called first, then error or deadlock,
+            then transition and (if the target is new) discovered for every transition.
+        */
+        class Observer
+        {
+        public:
+            virtual ~Observer() {}
+
+            /** @brief Called when a state gets its id (i.e. in the order of the ids).
+                @param from The state with the transition discovering the state, nullptr for the initial state.
+                @param i The index of the transition in from.
+            */
+            virtual void discovered(std::size_t id, const CCSRef<CCSProcess>& p, const State* from, std::size_t i) {}
+
+            /** @brief Called for every explored state. */
+            virtual void state(const State& s) {}
+
+            /** @brief Called for every transition of an explored state. */
+            virtual void transition(const State& s, std::size_t i) {}
+
+            /** @brief Called for every explored state without transitions (unless there was an error). */
+            virtual void deadlock(const State& s) {}
+
+            /** @brief Called for every state whose transition inference threw a CCSException.
+                @returns false to stop the exploration (the following observers are not called).
+            */
+            virtual bool error(const State& s) { return true; }
+
+            /** @brief Called for every discovered, but unexplored state if the exploration stops at the maximum depth. */
+            virtual void unexplored(std::size_t id, const CCSRef<CCSProcess>& p) {}
+
+            /** @brief Called when the exploration is finished (unless it was stopped by an error). */
+            virtual void finished() {}
+        };
+
+    private:
+        static const std::size_t npos = -1;
+        static const std::size_t shardBits = 6;
+
+        struct Entry
+        {
+            std::size_t id;
+            uint64_t key;   //(index in the layer << 32) | index of the transition, while id is npos
+        };
+
+        struct FingerprintHash
+        {
+            std::size_t operator() (uint64_t fingerprint) const
+            { return fingerprint; }
+        };
+
+        typedef CCSHashMap<CCSRef<CCSProcess>, Entry, PtrHash<CCSProcess>, PtrEq<CCSProcess>> Table;
+        typedef CCSHashMap<uint64_t, Entry, FingerprintHash, std::equal_to<uint64_t>> FingerprintTable;
+
+        struct Shard
+        {
+            std::mutex lock;
+            Table states;
+            FingerprintTable fingerprints;  //used instead of states with hash compaction
+        };
+
+        struct Discovery
+        {
+            uint64_t key;
+            CCSRef<CCSProcess> process;
+        };
+
+        CCSProgram& program;
+        bool fold;
+        bool compact;
+        CCSBudget* budget;
+        std::vector<CCSProgram> copies;
+        Shard shards[1 << shardBits];
+        std::vector<CCSRef<CCSProcess>> frontier;
+        std::size_t frontierId;
+        std::vector<State> layer;
+        std::vector<std::vector<Discovery>> discovered;
+        bool wasAtomic;
+
+        std::vector<std::thread> workers;
+        std::mutex lock;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(unsigned)>* task;
+        uint64_t generation;
+        unsigned running;
+        bool stopping;
+        std::vector<std::exception_ptr> errors;
+
+        Shard& shard(const CCSRef<CCSProcess>& p);
+        std::pair<Entry*, bool> insert(Shard& s, const CCSRef<CCSProcess>& p, Entry e);
+        Entry* find(const CCSRef<CCSProcess>& p);
+        CCSProgram& programOf(unsigned worker);
+        void work(unsigned worker);
+        void runTask(unsigned worker);
+        void runParallel(const std::function<void(unsigned)>& f);
+        void forEach(std::size_t n, std::size_t chunk, const std::function<void(std::size_t, unsigned)>& f);
+        void expandLayer();
+
+    public:
+        /** @brief Constructs an explorer for the main process of a program.
+            @param fold True if constant expression should be folded to constants.
+            @param threads The number of threads (at least 1).
+            @param compact True if the visited table should only store the 64 bit hashes of the states (hash compaction),
+                so only the terms of the current and the next layer are kept, and the targets of the transitions
+                are nullptr. Two states with the same hash are considered equal, so states may be missed,
+                but the probability is negligible for less than billions of states.
+        */
+        CCSExplorer(CCSProgram& program, bool fold = true, unsigned threads = 1, bool compact = false);
+
+        /** @brief Destructor, stops the worker threads. */
+        ~CCSExplorer();
+
+        CCSExplorer(const CCSExplorer&) = delete;
+        CCSExplorer& operator= (const CCSExplorer&) = delete;
+
+        /** @brief Returns the number of threads. */
+        unsigned getThreads() const;
+
+        /** @brief Sets the budget of the exploration (nullptr for none), which must live until explore returns.
+            If a limit is exceeded, explore stops like at the maximum depth: the discovered states
+            that were not explored are reported as unexplored.
+        */
+        void setBudget(CCSBudget* budget);
+
+        /** @brief Explores the LTS up to a depth and calls visit for every explored state in BFS order.
+            The visitor is called on the calling thread, after the whole layer of the state has been explored.
+            Can only be called once.
+            @param maxDepth The number of layers to explore, or a negative number to explore all states.
+            @returns false if the visitor stopped the exploration.
+        */
+        bool explore(int maxDepth, const Visitor& visit);
+
+        /** @brief Explores the LTS up to a depth and notifies the observers in the given order.
+            Can only be called once.
+            @param maxDepth The number of layers to explore, or a negative number to explore all states.
+            @returns false if an observer stopped the exploration.
+        */
+        bool explore(int maxDepth, const std::vector<Observer*>& observers);
+
+        /** @brief Explores the LTS up to a depth, stores it in lts (which must be empty) and notifies the observers.
+            Can only be called once.
+            @returns false if an observer stopped the exploration (lts then contains the states explored so far).
+        */
+        bool explore(int maxDepth, CCSLTS& lts, const std::vector<Observer*>& observers = {});
+
+        /** @brief Returns the discovered, but unexplored states after explore stopped at maxDepth. */
+        const std::vector<CCSRef<CCSProcess>>& getFrontier() const;
+
+        /** @brief Returns the id of a discovered state, or -1 if it was not discovered. */
+        std::size_t getId(const CCSRef<CCSProcess>& p);
+
+        /** @brief Returns the number of discovered states. */
+        std::size_t size();
+    };
+}
+
+#endif //CCSPP_CCSEXPLORER_H_INCLUDED
@@ -0,0 +1,202 @@
+#include "ccsexternal.h"
+#include "ccs.h"
+#include <algorithm>
+#include <atomic>
+#include <unistd.h>
+
+using namespace std;
+using namespace ccspp;
+
+static atomic<unsigned> fileCounter(0);
+
+const size_t CCSRecordFile::bufferSize;
+const size_t CCSExternalSorter::maxFanIn;
+
+CCSRecordFile::CCSRecordFile(const string& dir, size_t width)
+    :buffer(new char[bufferSize]), width(width), count(0)
+{
+    string path = dir + "/ccs++-" + to_string(getpid()) + "-" + to_string(fileCounter++) + ".tmp";
+    file = fopen(path.c_str(), "w+b");
+    if(!file)
+        throw CCSException("cannot create temporary file `" + path + "`");
+    //the file stays accessible through the handle until it is closed
+    remove(path.c_str());
+    //the buffer is given explicitly, since the C library may ignore the size otherwise
+    setvbuf(file, buffer.get(), _IOFBF, bufferSize);
+}
+
+CCSRecordFile::~CCSRecordFile()
+{ fclose(file); }
+
+void CCSRecordFile::write(const uint32_t* r)
+{
+    if(fwrite(r, sizeof(uint32_t), width, file) != width)
+        throw CCSException("cannot write temporary file");
+    count++;
+}
+
+void CCSRecordFile::rewind()
+{
+    if(fflush(file) != 0)
+        throw CCSException("cannot write temporary file");
+    std::rewind(file);
+}
+
+bool CCSRecordFile::read(uint32_t* r)
+{ return fread(r, sizeof(uint32_t), width, file) == width; }
+
+void CCSRecordFile::read(size_t index, uint32_t* r)
+{ read(index, r, 1); }
+
+void CCSRecordFile::read(size_t index, uint32_t* r, size_t n)
+{
+    //seeking also flushes the records written so far
+    if(fseeko(file, (off_t)(index * width * sizeof(uint32_t)), SEEK_SET) != 0 || fread(r, sizeof(uint32_t), n * width, file) != n * width)
+        throw CCSException("cannot read temporary file");
+    if(fseeko(file, 0, SEEK_END) != 0)
+        throw CCSException("cannot read temporary file");
+}
+
+size_t CCSRecordFile::size() const
+{ return count; }
+
+CCSExternalSorter::CCSExternalSorter(const string& dir, size_t width, size_t memory)
+    :dir(dir), width(width), memory(memory), next(0), spills(0), blockSize(0), count(0)
+{
+    //a record needs its words and its index in order, and the file of the runs needs its buffer
+    size_t bytes = memory > CCSRecordFile::bufferSize ? memory - CCSRecordFile::bufferSize : 0;
+    capacity = max(bytes / ((width + 1) * sizeof(uint32_t)), (size_t)16);
+}
+
+bool CCSExternalSorter::less(const uint32_t* r1, const uint32_t* r2) const
+{ return lexicographical_compare(r1, r1 + width, r2, r2 + width); }
+
+void CCSExternalSorter::sortBuffer()
+{
+    order.resize(buffer.size() / width);
+    for(size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t i, uint32_t j)
+        { return less(&buffer[i * width], &buffer[j * width]); });
+}
+
+void CCSExternalSorter::spill()
+{
+    sortBuffer();
+    if(!file)
+        file.reset(new CCSRecordFile(dir, width));
+    for(uint32_t i : order)
+        file->write(&buffer[i * width]);
+    runs.push_back(file->size());
+    spills++;
+    buffer.clear();
+}
+
+void CCSExternalSorter::add(const uint32_t* r)
+{
+    if(buffer.size() >= capacity * width)
+        spill();
+    buffer.insert(buffer.end(), r, r + width);
+    count++;
+}
+
+bool CCSExternalSorter::fill(size_t k)
+{
+    Cursor& c = cursors[k];
+    if(c.pos == c.end)
+        return false;
+    size_t n = min(blockSize, c.end - c.pos);
+    file->read(c.pos, &blocks[k * blockSize * width], n);
+    c.pos += n;
+    c.head = 0;
+    c.filled = n;
+    return true;
+}
+
+void CCSExternalSorter::merge(size_t first, size_t last)
+{
+    cursors.clear();
+    heap.clear();
+    for(size_t i = first; i < last; i++)
+    {
+        cursors.push_back(Cursor{ i == 0 ? 0 : runs[i - 1], runs[i], 0, 0 });
+        if(fill(i - first))
+            heap.push_back(i - first);
+    }
+    make_heap(heap.begin(), heap.end(), [&](size_t k1, size_t k2)
+        { return less(&blocks[(k2 * blockSize + cursors[k2].head) * width], &blocks[(k1 * blockSize + cursors[k1].head) * width]); });
+}
+
+bool CCSExternalSorter::pop(uint32_t* r)
+{
+    if(heap.empty())
+        return false;
+    auto greater = [&](size_t k1, size_t k2)
+        { return less(&blocks[(k2 * blockSize + cursors[k2].head) * width], &blocks[(k1 * blockSize + cursors[k1].head) * width]); };
+    pop_heap(heap.begin(), heap.end(), greater);
+    size_t k = heap.back();
+    Cursor& c = cursors[k];
+    copy_n(&blocks[(k * blockSize + c.head) * width], width, r);
+    if(++c.head < c.filled || fill(k))
+        push_heap(heap.begin(), heap.end(), greater);
+    else
+        heap.pop_back();
+    return true;
+}
+
+void CCSExternalSorter::sort()
+{
+    next = 0;
+    if(!file)
+    {
+        sortBuffer();
+        return;
+    }
+
+    if(!buffer.empty())
+        spill();
+    vector<uint32_t>().swap(buffer);
+    vector<uint32_t>().swap(order);
+
+    //the blocks get the memory of the buffer, except for the buffers of the file read and the file written by a pass
+    size_t bytes = memory > 2 * CCSRecordFile::bufferSize ? memory - 2 * CCSRecordFile::bufferSize : 0;
+    size_t fanIn = min(max(bytes / CCSRecordFile::bufferSize, (size_t)2), maxFanIn);
+    blockSize = max(bytes / fanIn / (width * sizeof(uint32_t)), (size_t)1);
+    blocks.resize(min(fanIn, runs.size()) * blockSize * width);
+
+    //groups of runs are merged into the runs of a new file, until they can be merged at once
+    vector<uint32_t> r(width);
+    while(runs.size() > fanIn)
+    {
+        unique_ptr<CCSRecordFile> merged(new CCSRecordFile(dir, width));
+        vector<size_t> ends;
+        for(size_t first = 0; first < runs.size(); first += fanIn)
+        {
+            merge(first, min(first + fanIn, runs.size()));
+            while(pop(r.data()))
+                merged->write(r.data());
+            ends.push_back(merged->size());
+        }
+        file = move(merged);
+        runs = move(ends);
+    }
+    merge(0, runs.size());
+}
+
+bool CCSExternalSorter::read(uint32_t* r)
+{
+    if(!file)
+    {
+        if(next == order.size())
+            return false;
+        copy_n(&buffer[order[next++] * width], width, r);
+        return true;
+    }
+    return pop(r);
+}
+
+size_t CCSExternalSorter::size() const
+{ return count; }
+
+size_t CCSExternalSorter::getRuns() const
+{ return spills; }
@@ -0,0 +1,137 @@
+#ifndef CCSPP_CCSEXTERNAL_H_INCLUDED
+#define CCSPP_CCSEXTERNAL_H_INCLUDED
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ccspp
+{
+    /** @brief Temporary file of records of a fixed number of 32 bit words.
+
+        The file is created in a directory and removed from it right away, so it disappears when it is closed,
+        even if the program is killed. Records are appended with write, rewind switches to reading them
+        from the beginning, and records can be read by their index. Throws a CCSException if the file
+        cannot be created or written (e.g. if the disk is full).
+    */
+    class CCSRecordFile
+    {
+    public:
+        /** @brief The size of the buffer of every file in bytes. */
+        static const std::size_t bufferSize = 1 << 16;
+
+    private:
+        std::unique_ptr<char[]> buffer;
+        std::FILE* file;
+        std::size_t width;
+        std::size_t count;
+
+    public:
+        /** @brief Creates an empty file in a directory for records of width words. */
+        CCSRecordFile(const std::string& dir, std::size_t width);
+        ~CCSRecordFile();
+
+        CCSRecordFile(const CCSRecordFile&) = delete;
+        CCSRecordFile& operator= (const CCSRecordFile&) = delete;
+
+        /** @brief Appends a record. */
+        void write(const uint32_t* r);
+
+        /** @brief Moves to the first record. */
+        void rewind();
+
+        /** @brief Reads the next record into r. \returns false if there is none. */
+        bool read(uint32_t* r);
+
+        /** @brief Reads the record with an index into r (which must be less than size) and moves to the end,
+            so records can be appended again.
+        */
+        void read(std::size_t index, uint32_t* r);
+
+        /** @brief Reads n records starting with the record with an index into r (index + n must not be greater than size)
+            and moves to the end like read.
+        */
+        void read(std::size_t index, uint32_t* r, std::size_t n);
+
+        /** @brief Returns the number of records written. */
+        std::size_t size() const;
+    };
+
+    /** @brief External merge sort of records of a fixed number of 32 bit words, ordered lexicographically.
+
+        Records are collected in a buffer of a bounded size. A full buffer is sorted and appended to a temporary
+        file as a run, and the runs are merged while the records are read. If all records fit into the buffer,
+        no file is written. Sorting by several fields is done by putting them into the records in that order.
+
+        A merge reads a block of every run at a time, and the blocks share the memory of the buffer, so at most
+        maxFanIn runs are merged at once. If there are more runs, groups of them are merged into a new file first,
+        until the runs can be merged while reading. The sorter only keeps two files open.
+    */
+    class CCSExternalSorter
+    {
+    public:
+        /** @brief The maximum number of runs merged at once. */
+        static const std::size_t maxFanIn = 64;
+
+    private:
+        //a run being merged: the records [pos, end) of the file are not read yet, [head, filled) of its block are
+        struct Cursor
+        {
+            std::size_t pos;
+            std::size_t end;
+            std::size_t head;
+            std::size_t filled;
+        };
+
+        std::string dir;
+        std::size_t width;
+        std::size_t memory;
+        std::size_t capacity;   //the number of records of the buffer
+        std::vector<uint32_t> buffer;
+        std::vector<uint32_t> order;
+        std::size_t next;
+        std::unique_ptr<CCSRecordFile> file;    //the runs, one after another
+        std::vector<std::size_t> runs;  //the end of every run in file
+        std::size_t spills;
+        std::size_t blockSize;  //the number of records of a block
+        std::vector<uint32_t> blocks;
+        std::vector<Cursor> cursors;
+        std::vector<std::size_t> heap;  //the runs with records left, smallest head first
+        std::size_t count;
+
+        bool less(const uint32_t* r1, const uint32_t* r2) const;
+        void sortBuffer();
+        void spill();
+        bool fill(std::size_t k);
+        void merge(std::size_t first, std::size_t last);
+        bool pop(uint32_t* r);
+
+    public:
+        /** @brief Constructs an empty sorter for records of width words, writing runs to dir
+            and using about memory bytes for the buffer, the blocks of the merge and the buffers of its files.
+        */
+        CCSExternalSorter(const std::string& dir, std::size_t width, std::size_t memory);
+
+        CCSExternalSorter(const CCSExternalSorter&) = delete;
+        CCSExternalSorter& operator= (const CCSExternalSorter&) = delete;
+
+        /** @brief Adds a record (only before sort). */
+        void add(const uint32_t* r);
+
+        /** @brief Ends adding records and starts reading them in sorted order. */
+        void sort();
+
+        /** @brief Reads the next record in sorted order into r. \returns false if there is none. */
+        bool read(uint32_t* r);
+
+        /** @brief Returns the number of records added. */
+        std::size_t size() const;
+
+        /** @brief Returns the number of runs written to files. */
+        std::size_t getRuns() const;
+    };
+}
+
+#endif //CCSPP_CCSEXTERNAL_H_INCLUDED
@@ -0,0 +1,197 @@
+#ifndef CCSPP_CCSHASH_H_INCLUDED
+#define CCSPP_CCSHASH_H_INCLUDED
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ccspp
+{
+    /** @brief Hash map with open addressing and linear probing.
+
+        Meant for large state tables: the slots are stored in one contiguous array together with the hash of their key,
+        so a lookup usually touches one cache line and only calls Eq on a full hash match.
+        Pointers to values are invalidated by insert (rehashing) and erase (backward shift deletion).
+    */
+    template<typename K, typename V, typename Hash, typename Eq>
+    class CCSHashMap
+    {
+    private:
+        struct Slot
+        {
+            std::size_t hash; //0 marks an empty slot
+            K key;
+            V value;
+        };
+
+        std::vector<Slot> slots;
+        std::size_t used;
+        Hash hasher;
+        Eq eq;
+
+        static std::size_t fixHash(std::size_t h)
+        { return h == 0 ? 1 : h; }
+
+        std::size_t mask() const
+        { return slots.size() - 1; }
+
+        std::size_t findSlot(const K& key, std::size_t h) const
+        {
+            if(slots.empty())
+                return -1;
+            for(std::size_t i = h & mask();; i = (i + 1) & mask())
+            {
+                const Slot& s = slots[i];
+                if(s.hash == 0)
+                    return -1;
+                if(s.hash == h && eq(s.key, key))
+                    return i;
+            }
+        }
+
+        void grow()
+        {
+            std::vector<Slot> old;
+            old.swap(slots);
+            slots.resize(old.empty() ? 16 : old.size() * 2);
+            for(Slot& s : old)
+                if(s.hash != 0)
+                {
+                    std::size_t i = s.hash & mask();
+                    while(slots[i].hash != 0)
+                        i = (i + 1) & mask();
+                    slots[i] = std::move(s);
+                }
+        }
+
+    public:
+        CCSHashMap(Hash hasher = Hash(), Eq eq = Eq())
+            :used(0), hasher(hasher), eq(eq)
+        {}
+
+        /** @brief Inserts key with value if it is not already contained.
+            \returns a pointer to the value in the map and true if the key was inserted.
+        */
+        std::pair<V*, bool> insert(const K& key, V value = V())
+        {
+            if((used + 1) * 4 > slots.size() * 3)
+                grow();
+            std::size_t h = fixHash(hasher(key));
+            std::size_t i = h & mask();
+            for(;; i = (i + 1) & mask())
+            {
+                Slot& s = slots[i];
+                if(s.hash == 0)
+                    break;
+                if(s.hash == h && eq(s.key, key))
+                    return { &s.value, false };
+            }
+            Slot& s = slots[i];
+            s.hash = h;
+            s.key = key;
+            s.value = std::move(value);
+            used++;
+            return { &s.value, true };
+        }
+
+        /** @brief Returns a pointer to the value of key, or nullptr if key is not contained. */
+        V* find(const K& key)
+        {
+            std::size_t i = findSlot(key, fixHash(hasher(key)));
+            return i == (std::size_t)-1 ? nullptr : &slots[i].value;
+        }
+
+        /** @brief Returns a pointer to the value of key, or nullptr if key is not contained. */
+        const V* find(const K& key) const
+        {
+            std::size_t i = findSlot(key, fixHash(hasher(key)));
+            return i == (std::size_t)-1 ? nullptr : &slots[i].value;
+        }
+
+        /** @brief Returns 1 if key is contained, 0 else. */
+        std::size_t count(const K& key) const
+        { return find(key) != nullptr; }
+
+        /** @brief Returns the value of key, inserting a default value if it is not contained. */
+        V& operator[] (const K& key)
+        { return *insert(key).first; }
+
+        /** @brief Removes key from the map.
+            \returns true if the key was contained.
+        */
+        bool erase(const K& key)
+        {
+            std::size_t i = findSlot(key, fixHash(hasher(key)));
+            if(i == (std::size_t)-1)
+                return false;
+            //backward shift deletion: move following entries of the cluster into the hole
+            std::size_t j = i;
+            for(;;)
+            {
+                j = (j + 1) & mask();
+                if(slots[j].hash == 0)
+                    break;
+                std::size_t home = slots[j].hash & mask();
+                if(((j - home) & mask()) >= ((j - i) & mask()))
+                {
+                    slots[i] = std::move(slots[j]);
+                    i = j;
+                }
+            }
+            slots[i] = Slot();
+            used--;
+            return true;
+        }
+
+        /** @brief Returns the number of entries. */
+        std::size_t size() const
+        { return used; }
+
+        /** @brief Returns true if the map is empty. */
+        bool empty() const
+        { return used == 0; }
+
+        /** @brief Removes all entries. */
+        void clear()
+        {
+            slots.clear();
+            used = 0;
+        }
+    };
+
+    /** @brief Hash set with open addressing and linear probing (see CCSHashMap). */
+    template<typename K, typename Hash, typename Eq>
+    class CCSHashSet
+    {
+    private:
+        struct Empty {};
+        CCSHashMap<K, Empty, Hash, Eq> map;
+
+    public:
+        /** @brief Inserts key. \returns true if key was not contained before. */
+        bool insert(const K& key)
+        { return map.insert(key).second; }
+
+        /** @brief Returns 1 if key is contained, 0 else. */
+        std::size_t count(const K& key) const
+        { return map.find(key) != nullptr; }
+
+        /** @brief Removes key. \returns true if the key was contained. */
+        bool erase(const K& key)
+        { return map.erase(key); }
+
+        /** @brief Returns the number of entries. */
+        std::size_t size() const
+        { return map.size(); }
+
+        /** @brief Returns true if the set is empty. */
+        bool empty() const
+        { return map.empty(); }
+
+        /** @brief Removes all entries. */
+        void clear()
+        { map.clear(); }
+    };
+}
+
+#endif //CCSPP_CCSHASH_H_INCLUDED
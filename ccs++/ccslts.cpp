@@ -0,0 +1,90 @@
+#include "ccslts.h"
+
+using namespace std;
+using namespace ccspp;
+
+const uint32_t CCSLTS::npos;
+
+CCSLTS::Builder::Builder(CCSLTS& lts)
+    :lts(lts)
+{}
+
+void CCSLTS::Builder::discovered(size_t id, const CCSRef<CCSProcess>& p, const CCSExplorer::State* from, size_t i)
+{ lts.addState(p); }
+
+void CCSLTS::Builder::state(const CCSExplorer::State& s)
+{
+    scratch.resize(s.trans.size());
+    for(size_t i = 0; i < s.trans.size(); i++)
+        scratch[i] = { lts.internAction(s.trans[i].getAction()), (uint32_t)s.targets[i] };
+    lts.addEdges(scratch, s.error);
+}
+
+
+
+CCSLTS::CCSLTS()
+    :offsets(1, 0)
+{}
+
+uint32_t CCSLTS::addState(const CCSRef<CCSProcess>& p)
+{
+    if(states.size() >= npos)
+        throw CCSException("too many states in LTS");
+    states.push_back(p);
+    errors.push_back(false);
+    return states.size() - 1;
+}
+
+void CCSLTS::addEdges(const vector<Edge>& e, bool error)
+{
+    errors[getExploredCount()] = error;
+    edges.insert(edges.end(), e.begin(), e.end());
+    offsets.push_back(edges.size());
+}
+
+uint32_t CCSLTS::internAction(const CCSAction& act)
+{
+    pair<uint32_t*, bool> ins = actionIds.insert(act, actions.size());
+    if(ins.second)
+        actions.push_back(act);
+    return *ins.first;
+}
+
+uint32_t CCSLTS::getActionId(const CCSAction& act) const
+{
+    const uint32_t* id = actionIds.find(act);
+    return id ? *id : npos;
+}
+
+const CCSAction& CCSLTS::getAction(uint32_t id) const
+{ return actions[id]; }
+
+uint32_t CCSLTS::getActionCount() const
+{ return actions.size(); }
+
+uint32_t CCSLTS::getStateCount() const
+{ return states.size(); }
+
+uint32_t CCSLTS::getExploredCount() const
+{ return offsets.size() - 1; }
+
+size_t CCSLTS::getEdgeCount() const
+{ return edges.size(); }
+
+const CCSRef<CCSProcess>& CCSLTS::getProcess(uint32_t s) const
+{ return states[s]; }
+
+bool CCSLTS::isError(uint32_t s) const
+{ return errors[s]; }
+
+const CCSLTS::Edge* CCSLTS::beginEdges(uint32_t s) const
+{ return edges.data() + (s < getExploredCount() ? offsets[s] : edges.size()); }
+
+const CCSLTS::Edge* CCSLTS::endEdges(uint32_t s) const
+{ return edges.data() + (s < getExploredCount() ? offsets[s + 1] : edges.size()); }
+
+const vector<size_t>& CCSLTS::getOffsets() const
+{ return offsets; }
+
+const vector<CCSLTS::Edge>& CCSLTS::getEdges() const
+{ return edges; }
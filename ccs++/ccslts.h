@@ -0,0 +1,116 @@
+#ifndef CCSPP_CCSLTS_H_INCLUDED
+#define CCSPP_CCSLTS_H_INCLUDED
+
+#include "ccs.h"
+#include "ccsexplorer.h"
+#include "ccshash.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace ccspp
+{
+    /** @brief An explicit labelled transition system with dense state ids.
+
+        The states are numbered like in CCSExplorer (0 is the initial state, the others in BFS order).
+        The transitions are stored in compressed sparse row form: the edges of state s are
+        getEdges()[getOffsets()[s]] to getEdges()[getOffsets()[s + 1]], sorted like the transitions of the process.
+        Actions are interned, an edge only stores the ids of its action and its target.
+
+        Only the first getExploredCount() states have been explored, the others were discovered,
+        but not explored (because of the maximum depth or because the exploration was stopped).
+        Explored states with an error have no edges.
+    */
+    class CCSLTS
+    {
+    public:
+        /** @brief A transition, stored at its source. */
+        struct Edge
+        {
+            /** @brief The id of the action (see getAction). */
+            uint32_t action;
+
+            /** @brief The id of the target state. */
+            uint32_t target;
+        };
+
+        /** @brief Observer filling an LTS during an exploration (see CCSExplorer::explore). */
+        class Builder : public CCSExplorer::Observer
+        {
+        private:
+            CCSLTS& lts;
+            std::vector<Edge> scratch;
+
+        public:
+            /** @brief Constructs a builder for an empty LTS. */
+            Builder(CCSLTS& lts);
+
+            virtual void discovered(std::size_t id, const CCSRef<CCSProcess>& p, const CCSExplorer::State* from, std::size_t i);
+            virtual void state(const CCSExplorer::State& s);
+        };
+
+        static const uint32_t npos = -1;
+
+    private:
+        std::vector<CCSRef<CCSProcess>> states;
+        std::vector<bool> errors;
+        std::vector<std::size_t> offsets;
+        std::vector<Edge> edges;
+        std::vector<CCSAction> actions;
+        CCSHashMap<CCSAction, uint32_t, std::hash<CCSAction>, std::equal_to<CCSAction>> actionIds;
+
+    public:
+        /** @brief Constructs an empty LTS. */
+        CCSLTS();
+
+        /** @brief Adds a state without edges and returns its id. */
+        uint32_t addState(const CCSRef<CCSProcess>& p);
+
+        /** @brief Adds the edges of the next unexplored state, which becomes explored.
+            @param error True if the transition inference of the state failed.
+        */
+        void addEdges(const std::vector<Edge>& e, bool error = false);
+
+        /** @brief Returns the id of an action, interning it if it is new. */
+        uint32_t internAction(const CCSAction& act);
+
+        /** @brief Returns the id of an action, or npos if it is not an action of the LTS. */
+        uint32_t getActionId(const CCSAction& act) const;
+
+        /** @brief Returns the action with the given id. */
+        const CCSAction& getAction(uint32_t id) const;
+
+        /** @brief Returns the number of actions. */
+        uint32_t getActionCount() const;
+
+        /** @brief Returns the number of states. */
+        uint32_t getStateCount() const;
+
+        /** @brief Returns the number of explored states (they have the ids 0 to getExploredCount() - 1). */
+        uint32_t getExploredCount() const;
+
+        /** @brief Returns the number of transitions. */
+        std::size_t getEdgeCount() const;
+
+        /** @brief Returns the process of a state. */
+        const CCSRef<CCSProcess>& getProcess(uint32_t s) const;
+
+        /** @brief Returns true if the transition inference of a state failed. */
+        bool isError(uint32_t s) const;
+
+        /** @brief Returns the first edge of a state. */
+        const Edge* beginEdges(uint32_t s) const;
+
+        /** @brief Returns the end of the edges of a state. */
+        const Edge* endEdges(uint32_t s) const;
+
+        /** @brief Returns the offsets of the edges of the explored states (getExploredCount() + 1 entries). */
+        const std::vector<std::size_t>& getOffsets() const;
+
+        /** @brief Returns the edges of all states. */
+        const std::vector<Edge>& getEdges() const;
+    };
+}
+
+#endif //CCSPP_CCSLTS_H_INCLUDED
@@ -0,0 +1,260 @@
+#include "ccsnormal.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+using namespace ccspp;
+
+CCSNormalizer::CCSNormalizer(const CCSProgram& program)
+    :bindings(program.getBindings())
+{}
+
+const set<pair<uint32_t, CCSAction::Type>>& CCSNormalizer::getActions(const string& name)
+{
+    auto it = nameActions.find(name);
+    if(it != nameActions.end())
+        return it->second;
+
+    //the actions of all names reachable from the definition, so nothing has to be looked up again
+    set<pair<uint32_t, CCSAction::Type>> actions;
+    set<string> seen{ name };
+    auto b = bindings.find(name);
+    if(b != bindings.end())
+        collect(b->second.getProcess(), actions, &seen);
+    return nameActions[name] = move(actions);
+}
+
+void CCSNormalizer::collect(const CCSRef<CCSProcess>& p, set<pair<uint32_t, CCSAction::Type>>& out, set<string>* seen)
+{
+    switch(p->getType())
+    {
+    case CCSProcess::PROCESSNAME:
+    {
+        const string& name = static_cast<CCSProcessName*>(p.get())->getName();
+        if(!seen)
+        {
+            const set<pair<uint32_t, CCSAction::Type>>& actions = getActions(name);
+            out.insert(actions.begin(), actions.end());
+        }
+        else if(seen->insert(name).second)
+        {
+            auto b = bindings.find(name);
+            if(b != bindings.end())
+                collect(b->second.getProcess(), out, seen);
+        }
+        return;
+    }
+    case CCSProcess::PREFIX:
+    {
+        CCSPrefix* q = static_cast<CCSPrefix*>(p.get());
+        CCSAction act = q->getAction();
+        //explicit termination prefixes are collected with the name id 0 (see terminates)
+        if(act.getNameId() != 0 || act.getType() == CCSAction::DELTA)
+            out.insert({ act.getNameId(), act.getType() });
+        collect(q->getProcess(), out, seen);
+        return;
+    }
+    case CCSProcess::CHOICE:
+        collect(static_cast<CCSChoice*>(p.get())->getLeft(), out, seen);
+        collect(static_cast<CCSChoice*>(p.get())->getRight(), out, seen);
+        return;
+    case CCSProcess::PARALLEL:
+        for(const CCSRef<CCSProcess>& q : static_cast<CCSParallel*>(p.get())->getProcesses())
+            collect(q, out, seen);
+        return;
+    case CCSProcess::RESTRICT:
+        //the actions restricted within the process are kept, which is safe
+        collect(static_cast<CCSRestrict*>(p.get())->getProcess(), out, seen);
+        return;
+    case CCSProcess::SEQUENTIAL:
+        collect(static_cast<CCSSequential*>(p.get())->getLeft(), out, seen);
+        collect(static_cast<CCSSequential*>(p.get())->getRight(), out, seen);
+        return;
+    case CCSProcess::WHEN:
+        collect(static_cast<CCSWhen*>(p.get())->getProcess(), out, seen);
+        return;
+    default:
+        return;
+    }
+}
+
+bool CCSNormalizer::restricts(const CCSRestrict& r, const CCSRef<CCSProcess>& p)
+{
+    set<pair<uint32_t, CCSAction::Type>> actions;
+    collect(p, actions, nullptr);
+    for(const pair<uint32_t, CCSAction::Type>& act : actions)
+        if(act.first != 0 && !r.allows(CCSAction(act.second, CCSSymbols::name(act.first))))
+            return true;
+    return false;
+}
+
+bool CCSNormalizer::terminates(const CCSRef<CCSProcess>& p)
+{
+    set<pair<uint32_t, CCSAction::Type>> actions;
+    collect(p, actions, nullptr);
+    return actions.count({ 0, CCSAction::DELTA }) != 0;
+}
+
+CCSRef<CCSProcess> CCSNormalizer::restrict(const CCSRestrict& r, const CCSRef<CCSProcess>& p)
+{
+    if(p->getType() == CCSProcess::RESTRICT)
+    {
+        const CCSRestrict& inner = *static_cast<CCSRestrict*>(p.get());
+        set<CCSAction> h = inner.getR();
+        if(inner.isComplement() == r.isComplement() && h == r.getR())
+            return p;
+        //a restriction to some names (complement) is not merged, the intersection would have to respect the action types
+        if(!inner.isComplement() && !r.isComplement())
+        {
+            set<CCSAction> k = r.getR();
+            h.insert(k.begin(), k.end());
+            CCSRef<CCSRestrict> merged = make_process<CCSRestrict>(inner.getProcess(), move(h));
+            return restrict(*merged, inner.getProcess());
+        }
+    }
+    if(!restricts(r, p))
+        return p;
+    return make_process<CCSRestrict>(p, r);
+}
+
+CCSRef<CCSProcess> CCSNormalizer::sequence(const CCSRef<CCSProcess>& p, const CCSRef<CCSProcess>& q)
+{
+    if(p->getType() == CCSProcess::CCSNULL)
+        return p;
+    else if(p->getType() == CCSProcess::SEQUENTIAL)
+    {
+        CCSSequential* s = static_cast<CCSSequential*>(p.get());
+        return make_process<CCSSequential>(s->getLeft(), sequence(s->getRight(), q));
+    }
+    return make_process<CCSSequential>(p, q);
+}
+
+static void flattenChoice(const CCSRef<CCSProcess>& p, vector<CCSRef<CCSProcess>>& out)
+{
+    if(p->getType() == CCSProcess::CHOICE)
+    {
+        flattenChoice(static_cast<CCSChoice*>(p.get())->getLeft(), out);
+        flattenChoice(static_cast<CCSChoice*>(p.get())->getRight(), out);
+    }
+    else if(p->getType() != CCSProcess::CCSNULL)
+        out.push_back(p);
+}
+
+//sorts the operands of a commutative operator and removes duplicates (processes are hash-consed)
+static void sortOperands(vector<CCSRef<CCSProcess>>& ps, bool unique)
+{
+    sort(ps.begin(), ps.end(), [](const CCSRef<CCSProcess>& p1, const CCSRef<CCSProcess>& p2)
+        { return p1->compare(*p2) < 0; });
+    if(unique)
+        ps.erase(std::unique(ps.begin(), ps.end()), ps.end());
+}
+
+CCSRef<CCSProcess> CCSNormalizer::rewrite(const CCSRef<CCSProcess>& p)
+{
+    switch(p->getType())
+    {
+    case CCSProcess::PREFIX:
+    {
+        CCSPrefix* q = static_cast<CCSPrefix*>(p.get());
+        CCSRef<CCSProcess> next = q->getProcess();
+        CCSRef<CCSProcess> n = normalize(next);
+        if(n == next)
+            return p;
+        return make_process<CCSPrefix>(q->getAction(), n);
+    }
+    case CCSProcess::CHOICE:
+    {
+        CCSChoice* q = static_cast<CCSChoice*>(p.get());
+        vector<CCSRef<CCSProcess>> ps;
+        flattenChoice(normalize(q->getLeft()), ps);
+        flattenChoice(normalize(q->getRight()), ps);
+        sortOperands(ps, true);
+        if(ps.empty())
+            return make_process<CCSNull>();
+        CCSRef<CCSProcess> res = ps[0];
+        for(size_t i = 1; i < ps.size(); i++)
+            res = make_process<CCSChoice>(res, ps[i]);
+        return res;
+    }
+    case CCSProcess::PARALLEL:
+    {
+        vector<CCSRef<CCSProcess>> ps;
+        CCSRef<CCSProcess> null;
+        CCSRef<CCSProcess> term;
+        auto add = [&](const CCSRef<CCSProcess>& n)
+        {
+            if(n->getType() == CCSProcess::CCSNULL)
+                null = n;
+            else if(n->getType() == CCSProcess::TERM)
+                term = n;
+            else
+                ps.push_back(n);
+        };
+        for(const CCSRef<CCSProcess>& q : static_cast<CCSParallel*>(p.get())->getProcesses())
+        {
+            CCSRef<CCSProcess> n = normalize(q);
+            if(n->getType() == CCSProcess::PARALLEL)
+                for(const CCSRef<CCSProcess>& r : static_cast<CCSParallel*>(n.get())->getProcesses())
+                    add(r);
+            else
+                add(n);
+        }
+        if(null)
+            ps.push_back(null);
+        else if(ps.empty())
+            return term;
+        else if(term)
+        {
+            //1 terminates to 0, so it can only be dropped if no other component can continue after terminating
+            //(a.e.1 | 1 deadlocks in 1 | 0 after [a, e], but a.e.1 does not)
+            for(const CCSRef<CCSProcess>& q : ps)
+                if(terminates(q))
+                {
+                    ps.push_back(term);
+                    break;
+                }
+        }
+        if(ps.size() == 1)
+            return ps[0];
+        sortOperands(ps, false);
+        return make_process<CCSParallel>(move(ps));
+    }
+    case CCSProcess::RESTRICT:
+    {
+        CCSRestrict* q = static_cast<CCSRestrict*>(p.get());
+        CCSRef<CCSProcess> inner = q->getProcess();
+        CCSRef<CCSProcess> n = normalize(inner);
+        if(n == inner && n->getType() != CCSProcess::RESTRICT && restricts(*q, n))
+            return p;
+        return restrict(*q, n);
+    }
+    case CCSProcess::SEQUENTIAL:
+    {
+        CCSSequential* q = static_cast<CCSSequential*>(p.get());
+        return sequence(normalize(q->getLeft()), normalize(q->getRight()));
+    }
+    case CCSProcess::WHEN:
+    {
+        CCSWhen* q = static_cast<CCSWhen*>(p.get());
+        CCSRef<CCSProcess> next = q->getProcess();
+        CCSRef<CCSProcess> n = normalize(next);
+        if(n == next)
+            return p;
+        return make_process<CCSWhen>(q->getCond(), n);
+    }
+    default:
+        return p;
+    }
+}
+
+CCSRef<CCSProcess> CCSNormalizer::normalize(const CCSRef<CCSProcess>& p)
+{
+    CCSRef<CCSProcess>* memo = normal.find(p);
+    if(memo)
+        return *memo;
+    CCSRef<CCSProcess> res = rewrite(p);
+    if(normal.size() >= maxEntries)
+        normal.clear();
+    normal.insert(p, res);
+    return res;
+}
@@ -0,0 +1,61 @@
+#ifndef CCSPP_CCSNORMAL_H_INCLUDED
+#define CCSPP_CCSNORMAL_H_INCLUDED
+
+#include "ccs.h"
+#include "ccshash.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace ccspp
+{
+    /** @brief Rewrites processes into a normal form modulo structural congruence.
+
+        The rewriting keeps the LTS of a process up to strong bisimilarity, so it can be applied to every successor
+        state, which merges states that only differ in their structure:
+
+        1. choices are flattened, sorted and deduplicated, and 0 is removed from them (P + 0 = P, P + P = P)
+        2. parallel compositions are sorted and 1 is removed from them, since all components terminate together
+           (P | 1 = P), unless a component has an explicit e prefix and could continue after terminating, then one 1
+           is kept; 0 is kept, since it never terminates, but several 0 become one and absorb all 1 (0 | 0 | 1 = 0)
+        3. nested restrictions are merged ((P\\H)\\K = P\\(H and K), or P\\H if H = K), and restrictions
+           of processes that cannot perform any of the restricted actions are removed (also through process names)
+        4. sequential compositions are nested to the right ((P; Q); R = P; (Q; R)), and 0; P = 0
+
+        1; P is not rewritten to P, since the termination of 1 is a tau transition. Process names are not unfolded.
+        The normal forms of the subterms are memoized (hash-consed processes are compared by pointer),
+        the memo is cleared when it gets too large, since it keeps its processes alive.
+    */
+    class CCSNormalizer
+    {
+    private:
+        static const std::size_t maxEntries = 1 << 16;
+
+        std::map<std::string, CCSBinding> bindings;
+        CCSHashMap<CCSRef<CCSProcess>, CCSRef<CCSProcess>, PtrHash<CCSProcess>, PtrEq<CCSProcess>> normal;
+        std::map<std::string, std::set<std::pair<uint32_t, CCSAction::Type>>> nameActions;
+
+        const std::set<std::pair<uint32_t, CCSAction::Type>>& getActions(const std::string& name);
+        void collect(const CCSRef<CCSProcess>& p, std::set<std::pair<uint32_t, CCSAction::Type>>& out,
+            std::set<std::string>* seen);
+        bool restricts(const CCSRestrict& r, const CCSRef<CCSProcess>& p);
+        bool terminates(const CCSRef<CCSProcess>& p);
+        CCSRef<CCSProcess> restrict(const CCSRestrict& r, const CCSRef<CCSProcess>& p);
+        CCSRef<CCSProcess> sequence(const CCSRef<CCSProcess>& p, const CCSRef<CCSProcess>& q);
+        CCSRef<CCSProcess> rewrite(const CCSRef<CCSProcess>& p);
+
+    public:
+        /** @brief Constructs a normalizer for the processes of a program (the bindings are copied). */
+        CCSNormalizer(const CCSProgram& program);
+
+        CCSNormalizer(const CCSNormalizer&) = delete;
+        CCSNormalizer& operator= (const CCSNormalizer&) = delete;
+
+        /** @brief Returns the normal form of a process. */
+        CCSRef<CCSProcess> normalize(const CCSRef<CCSProcess>& p);
+    };
+}
+
+#endif //CCSPP_CCSNORMAL_H_INCLUDED
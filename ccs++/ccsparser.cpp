@@ -392,11 +392,11 @@ unique_ptr<CCSProgram> CCSParser::parse()
     CCSToken t2 = lex.peek(1);
     while(t.type == CCSToken::TID && (t2.type == CCSToken::TLSQBR || t2.type == CCSToken::TCOLONEQ))
     {
-        shared_ptr<CCSProcessName> p = static_pointer_cast<CCSProcessName>(parsePrimaryProcess());
+        CCSRef<CCSProcessName> p = static_ref_cast<CCSProcessName>(parsePrimaryProcess());
 
         bool allnames = true;
         vector<string> params;
-        for(shared_ptr<CCSExp> next : p->getArgs())
+        for(CCSRef<CCSExp> next : p->getArgs())
             if(next->getType() == CCSExp::ID)
                 params.push_back(((CCSIdExp&)*next).getId());
             else
@@ -429,16 +429,16 @@ unique_ptr<CCSProgram> CCSParser::parse()
     return res;
 }
 
-shared_ptr<CCSExp> CCSParser::parseExp(int prec)
+CCSRef<CCSExp> CCSParser::parseExp(int prec)
 {
-    shared_ptr<CCSExp> res;
+    CCSRef<CCSExp> res;
 
     CCSToken t = lex.peek(0);
     switch(t.type)
     {
-    case CCSToken::TPLUS: lex.next(); res = make_shared<CCSUnaryExp>(CCSUnaryExp::PLUS, parseExp(prec_i)); break;
-    case CCSToken::TMINUS: lex.next(); res = make_shared<CCSUnaryExp>(CCSUnaryExp::MINUS, parseExp(prec_i)); break;
-    case CCSToken::TBANG: lex.next(); res = make_shared<CCSUnaryExp>(CCSUnaryExp::NOT, parseExp(prec_i)); break;
+    case CCSToken::TPLUS: lex.next(); res = make_exp<CCSUnaryExp>(CCSUnaryExp::PLUS, parseExp(prec_i)); break;
+    case CCSToken::TMINUS: lex.next(); res = make_exp<CCSUnaryExp>(CCSUnaryExp::MINUS, parseExp(prec_i)); break;
+    case CCSToken::TBANG: lex.next(); res = make_exp<CCSUnaryExp>(CCSUnaryExp::NOT, parseExp(prec_i)); break;
     default: res = parsePrimaryExp(); break;
     }
 
@@ -450,28 +450,28 @@ shared_ptr<CCSExp> CCSParser::parseExp(int prec)
         else
         {
             lex.next();
-            shared_ptr<CCSExp> rhs = parseExp(getRPrec(t.type));
+            CCSRef<CCSExp> rhs = parseExp(getRPrec(t.type));
             switch(t.type)
             {
-            case CCSToken::TPLUS: res = make_shared<CCSBinaryExp>(CCSBinaryExp::PLUS, res, rhs); break;
-            case CCSToken::TMINUS: res = make_shared<CCSBinaryExp>(CCSBinaryExp::MINUS, res, rhs); break;
-            case CCSToken::TSTAR: res = make_shared<CCSBinaryExp>(CCSBinaryExp::MUL, res, rhs); break;
-            case CCSToken::TSLASH: res = make_shared<CCSBinaryExp>(CCSBinaryExp::DIV, res, rhs); break;
-            case CCSToken::TPERCENT: res = make_shared<CCSBinaryExp>(CCSBinaryExp::MOD, res, rhs); break;
-            case CCSToken::TANDAND: res = make_shared<CCSBinaryExp>(CCSBinaryExp::AND, res, rhs); break;
-            case CCSToken::TPIPEPIPE: res = make_shared<CCSBinaryExp>(CCSBinaryExp::OR, res, rhs); break;
-            case CCSToken::TEQEQ: res = make_shared<CCSBinaryExp>(CCSBinaryExp::EQ, res, rhs); break;
-            case CCSToken::TNEQ: res = make_shared<CCSBinaryExp>(CCSBinaryExp::NEQ, res, rhs); break;
-            case CCSToken::TLT: res = make_shared<CCSBinaryExp>(CCSBinaryExp::LT, res, rhs); break;
-            case CCSToken::TLEQ: res = make_shared<CCSBinaryExp>(CCSBinaryExp::LEQ, res, rhs); break;
-            case CCSToken::TGT: res = make_shared<CCSBinaryExp>(CCSBinaryExp::GT, res, rhs); break;
-            case CCSToken::TGEQ: res = make_shared<CCSBinaryExp>(CCSBinaryExp::GEQ, res, rhs); break;
+            case CCSToken::TPLUS: res = make_exp<CCSBinaryExp>(CCSBinaryExp::PLUS, res, rhs); break;
+            case CCSToken::TMINUS: res = make_exp<CCSBinaryExp>(CCSBinaryExp::MINUS, res, rhs); break;
+            case CCSToken::TSTAR: res = make_exp<CCSBinaryExp>(CCSBinaryExp::MUL, res, rhs); break;
+            case CCSToken::TSLASH: res = make_exp<CCSBinaryExp>(CCSBinaryExp::DIV, res, rhs); break;
+            case CCSToken::TPERCENT: res = make_exp<CCSBinaryExp>(CCSBinaryExp::MOD, res, rhs); break;
+            case CCSToken::TANDAND: res = make_exp<CCSBinaryExp>(CCSBinaryExp::AND, res, rhs); break;
+            case CCSToken::TPIPEPIPE: res = make_exp<CCSBinaryExp>(CCSBinaryExp::OR, res, rhs); break;
+            case CCSToken::TEQEQ: res = make_exp<CCSBinaryExp>(CCSBinaryExp::EQ, res, rhs); break;
+            case CCSToken::TNEQ: res = make_exp<CCSBinaryExp>(CCSBinaryExp::NEQ, res, rhs); break;
+            case CCSToken::TLT: res = make_exp<CCSBinaryExp>(CCSBinaryExp::LT, res, rhs); break;
+            case CCSToken::TLEQ: res = make_exp<CCSBinaryExp>(CCSBinaryExp::LEQ, res, rhs); break;
+            case CCSToken::TGT: res = make_exp<CCSBinaryExp>(CCSBinaryExp::GT, res, rhs); break;
+            case CCSToken::TGEQ: res = make_exp<CCSBinaryExp>(CCSBinaryExp::GEQ, res, rhs); break;
             }
         }
     }
 }
 
-shared_ptr<CCSExp> CCSParser::parsePrimaryExp()
+CCSRef<CCSExp> CCSParser::parsePrimaryExp()
 {
     CCSToken t = lex.peek(0);
     if(t.type == CCSToken::TEOF)
@@ -481,14 +481,14 @@ shared_ptr<CCSExp> CCSParser::parsePrimaryExp()
     case CCSToken::TID:
     {
         lex.next();
-        return make_shared<CCSIdExp>(t.str);
+        return make_exp<CCSIdExp>(t.str);
     }
     case CCSToken::TNUM:
     {
         try
         {
             lex.next();
-            return make_shared<CCSConstExp>(stoi(t.str));
+            return make_exp<CCSConstExp>(stoi(t.str));
         }
         catch(exception& ex)
         {
@@ -498,7 +498,7 @@ shared_ptr<CCSExp> CCSParser::parsePrimaryExp()
     case CCSToken::TLPAR:
     {
         lex.next();
-        shared_ptr<CCSExp> res = parseExp();
+        CCSRef<CCSExp> res = parseExp();
         t = lex.peek(0);
         if(t.type == CCSToken::TEOF)
             throw CCSParserException(t, "unexpected end of file, expected `)`");
@@ -512,7 +512,7 @@ shared_ptr<CCSExp> CCSParser::parsePrimaryExp()
     }
 }
 
-shared_ptr<CCSProcess> CCSParser::parseProcess(int prec, shared_ptr<CCSProcess> res)
+CCSRef<CCSProcess> CCSParser::parseProcess(int prec, CCSRef<CCSProcess> res)
 {
     if(res == nullptr)
     {
@@ -521,8 +521,8 @@ shared_ptr<CCSProcess> CCSParser::parseProcess(int prec, shared_ptr<CCSProcess>
         if(t.type == CCSToken::TWHEN)
         {
             lex.next();
-            shared_ptr<CCSExp> cond = parseExp();
-            res = make_shared<CCSWhen>(cond, parseProcess(pprec_i));
+            CCSRef<CCSExp> cond = parseExp();
+            res = make_process<CCSWhen>(cond, parseProcess(pprec_i));
         }
         else if(t.type == CCSToken::TID && (t2.type == CCSToken::TLPAR || t2.type == CCSToken::TQUESTIONMARK || t2.type == CCSToken::TBANG || t2.type == CCSToken::TDOT))
         {
@@ -533,7 +533,7 @@ shared_ptr<CCSProcess> CCSParser::parseProcess(int prec, shared_ptr<CCSProcess>
             if(t.type != CCSToken::TDOT)
                 throw CCSParserException(t, "unexpected `" + t.str + "`, expected `.`");
             lex.next();
-            res = make_shared<CCSPrefix>(act, parseProcess(pprec_i));
+            res = make_process<CCSPrefix>(act, parseProcess(pprec_i));
         }
         else
             res = parsePrimaryProcess();
@@ -579,7 +579,7 @@ shared_ptr<CCSProcess> CCSParser::parseProcess(int prec, shared_ptr<CCSProcess>
             throw CCSParserException(t, "unexpected `" + t.str + "`, expected `}`");
         lex.next();
 
-        res = make_shared<CCSRestrict>(res, acts, comp);
+        res = make_process<CCSRestrict>(res, acts, comp);
     }
 
     for(;;)
@@ -590,34 +590,34 @@ shared_ptr<CCSProcess> CCSParser::parseProcess(int prec, shared_ptr<CCSProcess>
         else
         {
             lex.next();
-            shared_ptr<CCSProcess> rhs = parseProcess(getRPPrec(t.type));
+            CCSRef<CCSProcess> rhs = parseProcess(getRPPrec(t.type));
             switch(t.type)
             {
-            case CCSToken::TPLUS: res = make_shared<CCSChoice>(res, rhs); break;
-            case CCSToken::TPIPE: res = make_shared<CCSParallel>(res, rhs); break;
-            case CCSToken::TSEMICOLON: res = make_shared<CCSSequential>(res, rhs); break;
+            case CCSToken::TPLUS: res = make_process<CCSChoice>(res, rhs); break;
+            case CCSToken::TPIPE: res = make_process<CCSParallel>(res, rhs); break;
+            case CCSToken::TSEMICOLON: res = make_process<CCSSequential>(res, rhs); break;
             }
         }
     }
 }
 
-shared_ptr<CCSProcess> CCSParser::parsePrimaryProcess()
+CCSRef<CCSProcess> CCSParser::parsePrimaryProcess()
 {
     CCSToken t = lex.peek(0);
     if(t.type == CCSToken::TNUM && t.str == "0")
     {
         lex.next();
-        return make_shared<CCSNull>();
+        return make_process<CCSNull>();
     }
     else if(t.type == CCSToken::TNUM && t.str == "1")
     {
         lex.next();
-        return make_shared<CCSTerm>();
+        return make_process<CCSTerm>();
     }
     else if(t.type == CCSToken::TID)
     {
         string name = t.str;
-        vector<shared_ptr<CCSExp>> args;
+        vector<CCSRef<CCSExp>> args;
         t = lex.next();
         if(t.type == CCSToken::TLSQBR)
         {
@@ -636,12 +636,12 @@ shared_ptr<CCSProcess> CCSParser::parsePrimaryProcess()
                 throw CCSParserException(t, "unexpected `" + t.str + "`, expected `]`");
             lex.next();
         }
-        return make_shared<CCSProcessName>(name, args);
+        return make_process<CCSProcessName>(name, args);
     }
     else if(t.type == CCSToken::TLPAR)
     {
         lex.next();
-        shared_ptr<CCSProcess> res = parseProcess();
+        CCSRef<CCSProcess> res = parseProcess();
         t = lex.peek(0);
         if(t.type == CCSToken::TEOF)
             throw CCSParserException(t, "unexpected end of file, expected `)`");
@@ -671,7 +671,7 @@ CCSAction CCSParser::parseAction()
         return CCSAction(CCSAction::Type::DELTA);
     string name = t.str;
 
-    shared_ptr<CCSExp> param;
+    CCSRef<CCSExp> param;
     t = lex.peek(0);
     if(t.type == CCSToken::TLPAR)
     {
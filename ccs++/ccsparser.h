@@ -90,11 +90,11 @@ namespace ccspp
         int getLPPrec(CCSToken::Type type);
         int getRPPrec(CCSToken::Type type);
 
-        std::shared_ptr<CCSExp> parseExp(int prec = 0);
-        std::shared_ptr<CCSExp> parsePrimaryExp();
+        CCSRef<CCSExp> parseExp(int prec = 0);
+        CCSRef<CCSExp> parsePrimaryExp();
 
-        std::shared_ptr<CCSProcess> parseProcess(int prec = 0, std::shared_ptr<CCSProcess> res = nullptr);
-        std::shared_ptr<CCSProcess> parsePrimaryProcess();
+        CCSRef<CCSProcess> parseProcess(int prec = 0, CCSRef<CCSProcess> res = nullptr);
+        CCSRef<CCSProcess> parsePrimaryProcess();
         CCSAction parseAction();
 
     public:
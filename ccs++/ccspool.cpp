@@ -0,0 +1,168 @@
+#include "ccspool.h"
+#include <mutex>
+#include <new>
+
+using namespace std;
+using namespace ccspp;
+
+static CCSMemoryResource*& currentResource()
+{
+    static CCSMemoryResource* resource = nullptr;
+    return resource;
+}
+
+CCSMemoryResource* CCSMemoryResource::get()
+{
+    CCSMemoryResource* resource = currentResource();
+    return resource ? resource : CCSPool::instance();
+}
+
+void CCSMemoryResource::set(CCSMemoryResource* resource)
+{ currentResource() = resource; }
+
+
+
+void* CCSHeap::allocate(size_t size)
+{ return ::operator new(size); }
+
+void CCSHeap::deallocate(void* p, size_t size)
+{ ::operator delete(p); }
+
+CCSHeap* CCSHeap::instance()
+{
+    static CCSHeap heap;
+    return &heap;
+}
+
+
+
+//the pools of exited threads, never destroyed, terms may outlive static destruction
+static mutex& idleLock()
+{
+    static mutex* lock = new mutex();
+    return *lock;
+}
+
+static vector<CCSPool*>& idlePools()
+{
+    static vector<CCSPool*>* pools = new vector<CCSPool*>();
+    return *pools;
+}
+
+//owns the pool of a thread and hands it back to the idle pools when the thread exits
+struct CCSPool::ThreadPool
+{
+    CCSPool* pool;
+
+    ThreadPool()
+    {
+        lock_guard<mutex> lock(idleLock());
+        if(idlePools().empty())
+            pool = new CCSPool();
+        else
+        {
+            pool = idlePools().back();
+            idlePools().pop_back();
+            pool->owner.store(this_thread::get_id(), memory_order_release);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        //from now on all blocks freed into the pool go to the remote list until another thread takes it over
+        pool->owner.store(thread::id(), memory_order_release);
+        lock_guard<mutex> lock(idleLock());
+        idlePools().push_back(pool);
+    }
+};
+
+CCSPool::CCSPool()
+    :remote(nullptr), owner(this_thread::get_id()), chunkPos(nullptr), chunkEnd(nullptr)
+{
+    for(FreeBlock*& next : freeLists)
+        next = nullptr;
+}
+
+CCSPool::~CCSPool()
+{
+    for(char* chunk : chunks)
+        ::operator delete(chunk);
+}
+
+void CCSPool::reclaimRemote()
+{
+    RemoteBlock* block = remote.exchange(nullptr, memory_order_acquire);
+    while(block)
+    {
+        RemoteBlock* next = block->next;
+        FreeBlock* free = reinterpret_cast<FreeBlock*>(block);
+        size_t cls = block->cls;
+        free->next = freeLists[cls - 1];
+        freeLists[cls - 1] = free;
+        block = next;
+    }
+}
+
+void* CCSPool::allocate(size_t size)
+{
+    if(size > maxSize)
+        return ::operator new(size);
+    size_t cls = (size + granularity - 1) / granularity;
+    FreeBlock*& list = freeLists[cls - 1];
+    if(!list && remote.load(memory_order_relaxed))
+        reclaimRemote();
+    if(list)
+    {
+        FreeBlock* block = list;
+        list = block->next;
+        return block;
+    }
+
+    size_t bytes = cls * granularity;
+    if((size_t)(chunkEnd - chunkPos) < bytes)
+    {
+        //the rest of the current chunk is too small and is left unused
+        chunkPos = static_cast<char*>(::operator new(chunkSize));
+        chunkEnd = chunkPos + chunkSize;
+        chunks.push_back(chunkPos);
+    }
+    void* res = chunkPos;
+    chunkPos += bytes;
+    return res;
+}
+
+void CCSPool::deallocate(void* p, size_t size)
+{
+    if(size > maxSize)
+    {
+        ::operator delete(p);
+        return;
+    }
+    size_t cls = (size + granularity - 1) / granularity;
+    if(owner.load(memory_order_acquire) == this_thread::get_id())
+    {
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = freeLists[cls - 1];
+        freeLists[cls - 1] = block;
+        return;
+    }
+
+    RemoteBlock* block = static_cast<RemoteBlock*>(p);
+    block->cls = cls;
+    block->next = remote.load(memory_order_relaxed);
+    while(!remote.compare_exchange_weak(block->next, block, memory_order_release, memory_order_relaxed));
+}
+
+size_t CCSPool::getReserved() const
+{ return chunks.size() * chunkSize; }
+
+CCSPool* CCSPool::instance()
+{
+    static thread_local CCSPool* pool = nullptr;
+    if(!pool)
+    {
+        static thread_local ThreadPool threadPool;
+        pool = threadPool.pool;
+    }
+    return pool;
+}
@@ -0,0 +1,111 @@
+#ifndef CCSPP_CCSPOOL_H_INCLUDED
+#define CCSPP_CCSPOOL_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ccspp
+{
+    /** @brief Source of memory for CCS terms.
+
+        Processes and expressions are allocated through the current memory resource (see CCSRefCounted).
+        The resource is stored with every term, so a term is always freed by the resource that allocated it,
+        even if the current resource is changed in between.
+        If terms are created on several threads, the resource has to be thread-safe.
+    */
+    class CCSMemoryResource
+    {
+    public:
+        virtual ~CCSMemoryResource() {}
+
+        /** @brief Allocates size bytes, aligned for any object type. */
+        virtual void* allocate(std::size_t size) = 0;
+
+        /** @brief Frees memory returned by allocate(size). */
+        virtual void deallocate(void* p, std::size_t size) = 0;
+
+        /** @brief Returns the current memory resource (the pool of the calling thread by default). */
+        static CCSMemoryResource* get();
+
+        /** @brief Sets the current memory resource, used for all terms created from now on.
+            nullptr restores the default, the pool of the calling thread.
+        */
+        static void set(CCSMemoryResource* resource);
+    };
+
+    /** @brief Memory resource using the global heap (operator new and delete). */
+    class CCSHeap : public CCSMemoryResource
+    {
+    public:
+        virtual void* allocate(std::size_t size);
+        virtual void deallocate(void* p, std::size_t size);
+
+        /** @brief Returns the global heap resource. */
+        static CCSHeap* instance();
+    };
+
+    /** @brief Size-class pool for small objects.
+
+        Requests are rounded up to a multiple of 16 bytes. Every size class has a free list,
+        and new blocks are cut from 64 KiB chunks, so terms of the same size lie next to each other
+        and allocating or freeing a block costs a few instructions instead of a call to malloc or free.
+        Freed blocks are reused for the same size class but never returned to the heap before the pool is destroyed.
+        Requests larger than 512 bytes go to the heap.
+
+        A pool belongs to one thread (the thread that created it), and only this thread may allocate from it.
+        Blocks can be freed on any thread: blocks freed by other threads are pushed onto a lock-free list,
+        which the owner moves to its free lists when it runs out of blocks.
+    */
+    class CCSPool : public CCSMemoryResource
+    {
+    private:
+        static const std::size_t granularity = 16;
+        static const std::size_t maxSize = 512;
+        static const std::size_t chunkSize = 1 << 16;
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        struct RemoteBlock
+        {
+            RemoteBlock* next;
+            std::size_t cls;
+        };
+
+        FreeBlock* freeLists[maxSize / granularity];
+        std::atomic<RemoteBlock*> remote;
+        std::atomic<std::thread::id> owner;
+        std::vector<char*> chunks;
+        char* chunkPos;
+        char* chunkEnd;
+
+        struct ThreadPool;
+
+        void reclaimRemote();
+
+    public:
+        CCSPool();
+        virtual ~CCSPool();
+
+        CCSPool(const CCSPool&) = delete;
+        CCSPool& operator= (const CCSPool&) = delete;
+
+        virtual void* allocate(std::size_t size);
+        virtual void deallocate(void* p, std::size_t size);
+
+        /** @brief Returns the number of bytes allocated from the heap for chunks. */
+        std::size_t getReserved() const;
+
+        /** @brief Returns the pool of the calling thread (the default memory resource).
+            When a thread exits, its pool is kept (the terms allocated from it may still be alive)
+            and handed to the next thread that asks for a pool.
+        */
+        static CCSPool* instance();
+    };
+}
+
+#endif //CCSPP_CCSPOOL_H_INCLUDED
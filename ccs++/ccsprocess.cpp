@@ -1,29 +1,161 @@
 #include "ccs.h"
 #include "ccsvisitor.h"
+#include "ccsunique.h"
+#include "ccscache.h"
+#include "ccsnormal.h"
 #include <sstream>
 #include <algorithm>
 
 using namespace std;
 using namespace ccspp;
 
+static uint64_t actionKey(uint32_t name, CCSAction::Type type)
+{ return ((uint64_t)name << 8) | type; }
+
+//key of the channel of a send or receive action, type is the type of the action
+static uint64_t channelKey(const CCSAction& act, CCSAction::Type type)
+{
+    uint64_t key = actionKey(act.getNameId(), type);
+    return act.getParam() == nullptr ? key : hash_combine(key, act.getParam()->getHash());
+}
+
+static const size_t npos = -1;
+
+//scratch buffers for the synchronization in CCSParallel, reused to avoid allocations;
+//transition inference of the components is finished before the index is filled, so nested compositions do not interfere,
+//and every thread has its own buffers
+struct SyncIndex
+{
+    vector<size_t> heads;
+    vector<size_t> next;
+    vector<uint64_t> keys;
+    vector<size_t> comps;
+};
+
+static SyncIndex& syncIndex()
+{
+    static thread_local SyncIndex index;
+    return index;
+}
+
 CCSProcess::CCSProcess(Type type)
-    :type(type)
+    :type(type), hash(hash_mix(type + 1)), vars(0), interned(false), foldable(false)
 {}
 
+CCSProcess::~CCSProcess()
+{
+    if(interned)
+        uniqueTable().erase(this);
+}
+
+CCSUniqueTable<CCSProcess>& CCSProcess::uniqueTable()
+{
+    //never destroyed, processes may outlive static destruction
+    static CCSUniqueTable<CCSProcess>* table = new CCSUniqueTable<CCSProcess>();
+    return *table;
+}
+
+CCSRef<CCSProcess> CCSProcess::unique(CCSRef<CCSProcess> p)
+{ return uniqueTable().intern(p); }
+
+uint64_t CCSProcess::getHash() const
+{ return hash; }
+
 CCSProcess::Type CCSProcess::getType() const
 { return type; }
 
+uint64_t CCSProcess::getVars() const
+{ return vars; }
+
+bool CCSProcess::isFoldable() const
+{ return foldable; }
+
+CCSRef<CCSProcess> CCSProcess::subst(string id, int val, bool fold)
+{ return subst(CCSEnv({ CCSSymbols::intern(id) }, { val }), fold); }
+
+CCSRef<CCSProcess> CCSProcess::subst(const CCSEnv& env, bool fold)
+{
+    if(!(vars & env.getMask()) && !(fold && foldable))
+        return self();
+    return substitute(env, fold);
+}
+
+void CCSProcess::collectCached(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
+{
+    //the transitions of these processes are cheaper to compute than to look up,
+    //and a parallel composition is mostly a new global state, whose components are cached instead
+    CCSTransitionCache* cache = program.getCache();
+    if(cache == nullptr || type == CCSNULL || type == TERM || type == PREFIX || type == PARALLEL)
+    {
+        collectTransitions(program, fold, out, seen);
+        return;
+    }
+
+    const vector<CCSTransition>* cached = cache->find(this, fold, seen);
+    if(cached)
+    {
+        out.insert(out.end(), cached->begin(), cached->end());
+        return;
+    }
+    size_t a = out.size();
+    size_t mark = cache->mark();
+    collectTransitions(program, fold, out, seen);
+    cache->insert(self(), fold, mark, out.begin() + a, out.end());
+}
+
 set<CCSTransition> CCSProcess::getTransitions(CCSProgram& program, bool fold)
 {
-    set<CCSTransition> res = getTransitions(program, fold, {});
-    for(const CCSTransition& t : res)
-        if(t.getAction().getInput() != "")
-            throw CCSProcessException(t.getTo(), "unrestricted input variable `" + t.getAction().getInput() + "`");
-    return move(res);
+    vector<CCSTransition> res;
+    getTransitions(program, res, fold);
+    return set<CCSTransition>(res.begin(), res.end());
+}
+
+void CCSProcess::getTransitions(CCSProgram& program, vector<CCSTransition>& out, bool fold)
+{
+    getLocalTransitions(program, out, fold);
+    for(const CCSTransition& t : out)
+        if(t.act.getInputId() != 0)
+        {
+            CCSProcessException ex(t.to, "unrestricted input variable `" + t.act.getInput() + "`");
+            out.clear();
+            throw ex;
+        }
+
+    if(program.getNormalizer())
+        for(CCSTransition& t : out)
+            t.to = program.getNormalizer()->normalize(t.to);
+
+    //the transitions of the operands are not deduplicated, so this is the only place where duplicates are removed
+    sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end(), [](const CCSTransition& t1, const CCSTransition& t2)
+        { return t1.compare(t2) == 0; }), out.end());
+}
+
+void CCSProcess::getLocalTransitions(CCSProgram& program, vector<CCSTransition>& out, bool fold)
+{
+    out.clear();
+    vector<uint32_t> seen;
+    if(program.getCache())
+        program.getCache()->start();
+    try
+    {
+        collectCached(program, fold, out, seen);
+    }
+    catch(...)
+    {
+        out.clear();
+        throw;
+    }
+
+    CCSRef<CCSProcess> from = self();
+    for(CCSTransition& t : out)
+        t.from = from;
 }
 
 int CCSProcess::compare(const CCSProcess& p) const
 {
+    if(this == &p)
+        return 0;
     if(type < p.type)
         return -1;
     else if(type > p.type)
@@ -59,14 +191,12 @@ int CCSNull::compare(const CCSProcess* p2) const
     return 0;
 }
 
-set<CCSTransition> CCSNull::getTransitions(CCSProgram& program, bool fold, set<string> seen)
-{
-    return {};
-}
+void CCSNull::collectTransitions(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
+{}
 
-shared_ptr<CCSProcess> CCSNull::subst(string id, int val, bool fold)
+CCSRef<CCSProcess> CCSNull::substitute(const CCSEnv& env, bool fold)
 {
-    return shared_from_this();
+    return self();
 }
 
 void CCSNull::print(ostream& out) const
@@ -88,14 +218,14 @@ int CCSTerm::compare(const CCSProcess* p2) const
     return 0;
 }
 
-set<CCSTransition> CCSTerm::getTransitions(CCSProgram& program, bool fold, set<string> seen)
+void CCSTerm::collectTransitions(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
 {
-    return { CCSTransition(CCSAction(CCSAction::DELTA), shared_from_this(), make_shared<CCSNull>()) };
+    out.emplace_back(CCSAction(CCSAction::DELTA), nullptr, make_process<CCSNull>());
 }
 
-shared_ptr<CCSProcess> CCSTerm::subst(string id, int val, bool fold)
+CCSRef<CCSProcess> CCSTerm::substitute(const CCSEnv& env, bool fold)
 {
-    return shared_from_this();
+    return self();
 }
 
 void CCSTerm::print(ostream& out) const
@@ -108,25 +238,38 @@ void CCSTerm::accept(CCSVisitor<void>* v)
 
 
 
-CCSProcessName::CCSProcessName(string name, vector<shared_ptr<CCSExp>> args)
-    :CCSProcess(PROCESSNAME), name(name), args(args)
+CCSProcessName::CCSProcessName(string name, vector<CCSRef<CCSExp>> args)
+    :CCSProcessName(CCSSymbols::intern(name), move(args))
 {}
 
-string CCSProcessName::getName() const
-{ return name; }
+CCSProcessName::CCSProcessName(uint32_t nameId, vector<CCSRef<CCSExp>> args)
+    :CCSProcess(PROCESSNAME), nameId(nameId), args(move(args))
+{
+    hash = hash_combine(hash, hash_string(CCSSymbols::name(nameId)));
+    for(const CCSRef<CCSExp>& next : this->args)
+    {
+        hash = hash_combine(hash, next->getHash());
+        vars |= next->getVars();
+        foldable = foldable || next->isFoldable();
+    }
+}
+
+const string& CCSProcessName::getName() const
+{ return CCSSymbols::name(nameId); }
 
-vector<shared_ptr<CCSExp>> CCSProcessName::getArgs()
+uint32_t CCSProcessName::getNameId() const
+{ return nameId; }
+
+vector<CCSRef<CCSExp>> CCSProcessName::getArgs()
 { return args; }
 
 int CCSProcessName::compare(const CCSProcess* p2) const
 {
     CCSProcessName* _p2 = (CCSProcessName*)p2;
-    if(name < _p2->name)
-        return -1;
-    else if(name > _p2->name)
-        return 1;
+    if(nameId != _p2->nameId)
+        return getName() < _p2->getName() ? -1 : 1;
 
-    const vector<shared_ptr<CCSExp>>& args2 = _p2->args;;
+    const vector<CCSRef<CCSExp>>& args2 = _p2->args;;
     for(int i = 0; i < min(args.size(), args2.size()); i++)
     {
         int c = args.at(i)->compare(*args2.at(i));
@@ -142,46 +285,45 @@ int CCSProcessName::compare(const CCSProcess* p2) const
         return 0;
 }
 
-set<CCSTransition> CCSProcessName::getTransitions(CCSProgram& program, bool fold, set<string> seen)
+void CCSProcessName::collectTransitions(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
 {
     vector<int> args;
-    for(const shared_ptr<CCSExp>& next : this->args)
+    for(const CCSRef<CCSExp>& next : this->args)
         args.push_back(next->eval());
-    shared_ptr<CCSProcess> p = program.get(name, args, fold);
+    CCSRef<CCSProcess> p = program.get(nameId, args, fold);
 
-    if(seen.count(name))
-        throw CCSRecursionException(shared_from_this(), "unguarded recursion in process \"" + name + " := " + (string)*p + "\"");
-    seen.insert(name);
+    if(find(seen.begin(), seen.end(), nameId) != seen.end())
+        throw CCSRecursionException(static_ref_cast<CCSProcessName>(self()),
+            "unguarded recursion in process \"" + getName() + " := " + (string)*p + "\"");
     if(p)
     {
-        set<CCSTransition> res;
-        for(CCSTransition t : p->getTransitions(program, fold, seen))
-            res.emplace(t.getAction(), shared_from_this(), t.getTo());
-        return res;
+        if(program.getCache())
+            program.getCache()->instantiate(nameId);
+        seen.push_back(nameId);
+        p->collectCached(program, fold, out, seen);
+        seen.pop_back();
     }
-    else
-        return {};
 }
 
-shared_ptr<CCSProcess> CCSProcessName::subst(string id, int val, bool fold)
+CCSRef<CCSProcess> CCSProcessName::substitute(const CCSEnv& env, bool fold)
 {
-    vector<shared_ptr<CCSExp>> args2;
-    for(const shared_ptr<CCSExp>& next : args)
-        args2.push_back(next->subst(id, val, fold));
+    vector<CCSRef<CCSExp>> args2;
+    for(const CCSRef<CCSExp>& next : args)
+        args2.push_back(next->subst(env, fold));
     if(args2 == args)
-        return shared_from_this();
+        return self();
     else
-        return make_shared<CCSProcessName>(name, args2);
+        return make_process<CCSProcessName>(nameId, args2);
 }
 
 void CCSProcessName::print(ostream& out) const
 {
-    out << name;
+    out << getName();
     if(args.size())
     {
         out << "[";
         bool first = true;
-        for(const shared_ptr<CCSExp>& next : args)
+        for(const CCSRef<CCSExp>& next : args)
         {
             if(!first)
                 out << ", ";
@@ -197,14 +339,18 @@ void CCSProcessName::accept(CCSVisitor<void>* v)
 
 
 
-CCSPrefix::CCSPrefix(CCSAction act, shared_ptr<CCSProcess> p)
+CCSPrefix::CCSPrefix(CCSAction act, CCSRef<CCSProcess> p)
     :CCSProcess(PREFIX), act(act), p(p)
-{}
+{
+    hash = hash_combine(hash_combine(hash, act.getHash()), p->hash);
+    vars = act.getVars() | p->vars;
+    foldable = act.isFoldable() || p->foldable;
+}
 
 CCSAction CCSPrefix::getAction() const
 { return act; }
 
-shared_ptr<CCSProcess> CCSPrefix::getProcess() const
+CCSRef<CCSProcess> CCSPrefix::getProcess() const
 { return p; }
 
 int CCSPrefix::compare(const CCSProcess* p2) const
@@ -216,21 +362,25 @@ int CCSPrefix::compare(const CCSProcess* p2) const
     return p->compare(*_p2->p);
 }
 
-set<CCSTransition> CCSPrefix::getTransitions(CCSProgram& program, bool fold, set<string> seen)
+void CCSPrefix::collectTransitions(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
 {
-    return { CCSTransition(act.eval(), shared_from_this(), p) };
+    out.emplace_back(act.eval(), nullptr, p);
 }
 
-shared_ptr<CCSProcess> CCSPrefix::subst(string id, int val, bool fold)
+CCSRef<CCSProcess> CCSPrefix::substitute(const CCSEnv& env, bool fold)
 {
-    if(act.getInput() == id)
-        return shared_from_this();
-    CCSAction act2 = act.subst(id, val, fold);
-    shared_ptr<CCSProcess> p2 = p->subst(id, val, fold);
+    //the input variable is bound by the prefix, so it is not substituted in the prefix and its continuation
+    if(act.getInputId() != 0 && env.find(act.getInputId()))
+    {
+        CCSEnv env2 = env.without(act.getInputId());
+        return env2.empty() ? self() : subst(env2, fold);
+    }
+    CCSAction act2 = act.subst(env, fold);
+    CCSRef<CCSProcess> p2 = p->subst(env, fold);
     if(act2 == act && p2 == p)
-        return shared_from_this();
+        return self();
     else
-        return make_shared<CCSPrefix>(act2, p2);
+        return make_process<CCSPrefix>(act2, p2);
 }
 
 void CCSPrefix::print(ostream& out) const
@@ -245,14 +395,18 @@ void CCSPrefix::accept(CCSVisitor<void>* v)
 
 
 
-CCSChoice::CCSChoice(shared_ptr<CCSProcess> left, shared_ptr<CCSProcess> right)
+CCSChoice::CCSChoice(CCSRef<CCSProcess> left, CCSRef<CCSProcess> right)
     :CCSProcess(CHOICE), left(left), right(right)
-{}
+{
+    hash = hash_combine(hash_combine(hash, left->hash), right->hash);
+    vars = left->vars | right->vars;
+    foldable = left->foldable || right->foldable;
+}
 
-shared_ptr<CCSProcess> CCSChoice::getLeft() const
+CCSRef<CCSProcess> CCSChoice::getLeft() const
 { return left; }
 
-shared_ptr<CCSProcess> CCSChoice::getRight() const
+CCSRef<CCSProcess> CCSChoice::getRight() const
 { return right; }
 
 int CCSChoice::compare(const CCSProcess* p2) const
@@ -264,24 +418,20 @@ int CCSChoice::compare(const CCSProcess* p2) const
     return right->compare(*_p2->right);
 }
 
-set<CCSTransition> CCSChoice::getTransitions(CCSProgram& program, bool fold, set<string> seen)
+void CCSChoice::collectTransitions(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
 {
-    set<CCSTransition> res;
-    for(CCSTransition t : left->getTransitions(program, fold, seen))
-        res.emplace(t.getAction(), shared_from_this(), t.getTo());
-    for(CCSTransition t : right->getTransitions(program, fold, seen))
-        res.emplace(t.getAction(), shared_from_this(), t.getTo());
-    return res;
+    left->collectCached(program, fold, out, seen);
+    right->collectCached(program, fold, out, seen);
 }
 
-shared_ptr<CCSProcess> CCSChoice::subst(string id, int val, bool fold)
+CCSRef<CCSProcess> CCSChoice::substitute(const CCSEnv& env, bool fold)
 {
-    shared_ptr<CCSProcess> left2 = left->subst(id, val, fold);
-    shared_ptr<CCSProcess> right2 = right->subst(id, val, fold);
+    CCSRef<CCSProcess> left2 = left->subst(env, fold);
+    CCSRef<CCSProcess> right2 = right->subst(env, fold);
     if(left2 == left && right2 == right)
-        return shared_from_this();
+        return self();
     else
-        return make_shared<CCSChoice>(left2, right2);
+        return make_process<CCSChoice>(left2, right2);
 }
 
 void CCSChoice::print(ostream& out) const
@@ -298,129 +448,203 @@ void CCSChoice::accept(CCSVisitor<void>* v)
 
 
 
-CCSParallel::CCSParallel(shared_ptr<CCSProcess> left, shared_ptr<CCSProcess> right)
-    :CCSProcess(PARALLEL), left(left), right(right)
+CCSParallel::CCSParallel(CCSRef<CCSProcess> left, CCSRef<CCSProcess> right)
+    :CCSParallel(vector<CCSRef<CCSProcess>>{ left, right })
 {}
 
-shared_ptr<CCSProcess> CCSParallel::getLeft() const
-{ return left; }
+CCSParallel::CCSParallel(vector<CCSRef<CCSProcess>> ps)
+    :CCSProcess(PARALLEL)
+{
+    //nested parallel compositions are flattened into this one
+    bool flat = true;
+    for(const CCSRef<CCSProcess>& p : ps)
+        if(p->type == PARALLEL)
+            flat = false;
+    if(flat)
+        this->ps = move(ps);
+    else
+        for(const CCSRef<CCSProcess>& p : ps)
+            if(p->type == PARALLEL)
+            {
+                const vector<CCSRef<CCSProcess>>& ps2 = ((CCSParallel*)p.get())->ps;
+                this->ps.insert(this->ps.end(), ps2.begin(), ps2.end());
+            }
+            else
+                this->ps.push_back(p);
 
-shared_ptr<CCSProcess> CCSParallel::getRight() const
-{ return right; }
+    for(const CCSRef<CCSProcess>& p : this->ps)
+    {
+        hash = hash_combine(hash, p->hash);
+        vars |= p->vars;
+        foldable = foldable || p->foldable;
+    }
+}
+
+const vector<CCSRef<CCSProcess>>& CCSParallel::getProcesses() const
+{ return ps; }
 
 int CCSParallel::compare(const CCSProcess* p2) const
 {
     CCSParallel* _p2 = (CCSParallel*)p2;
-    int c = left->compare(*_p2->left);
-    if(c != 0)
-        return c;
-    return right->compare(*_p2->right);
+    for(size_t i = 0; i < ps.size() && i < _p2->ps.size(); i++)
+    {
+        int c = ps[i]->compare(*_p2->ps[i]);
+        if(c != 0)
+            return c;
+    }
+    if(ps.size() < _p2->ps.size())
+        return -1;
+    else if(ps.size() > _p2->ps.size())
+        return 1;
+    return 0;
 }
 
-set<CCSTransition> CCSParallel::getTransitions(CCSProgram& program, bool fold, set<string> seen)
+CCSRef<CCSProcess> CCSParallel::replace(size_t i, CCSRef<CCSProcess> p) const
 {
-    set<CCSTransition> res;
-    set<CCSTransition> resl = left->getTransitions(program, fold, seen);
-    set<CCSTransition> resr = right->getTransitions(program, fold, seen);
+    vector<CCSRef<CCSProcess>> ps2 = ps;
+    ps2[i] = move(p);
+    return make_process<CCSParallel>(move(ps2));
+}
 
-    for(const CCSTransition& t : resl)
-    {
-        CCSAction act = t.getAction();
-        if(act.getType() == CCSAction::DELTA)
-            continue;
-        res.emplace(act, shared_from_this(), make_shared<CCSParallel>(t.getTo(), right));
-    }
+CCSRef<CCSProcess> CCSParallel::replace(size_t i, CCSRef<CCSProcess> p, size_t j, CCSRef<CCSProcess> q) const
+{
+    vector<CCSRef<CCSProcess>> ps2 = ps;
+    ps2[i] = move(p);
+    ps2[j] = move(q);
+    return make_process<CCSParallel>(move(ps2));
+}
 
-    for(const CCSTransition& t : resr)
+void CCSParallel::collectTransitions(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
+{
+    //the transitions of all components are collected at the end of out and replaced by the combined ones,
+    //the transitions of component k are in [bounds[k], bounds[k + 1])
+    size_t a = out.size();
+    vector<size_t> bounds;
+    bounds.reserve(ps.size() + 1);
+    for(const CCSRef<CCSProcess>& p : ps)
     {
-        CCSAction act = t.getAction();
-        if(t.getAction().getType() == CCSAction::DELTA)
-            continue;
-        res.emplace(act, shared_from_this(), make_shared<CCSParallel>(left, t.getTo()));
+        bounds.push_back(out.size());
+        p->collectCached(program, fold, out, seen);
     }
-
-    for(const CCSTransition& t : resl)
-    {
-        CCSAction act = t.getAction();
-        if(act.getType() != CCSAction::SEND && act.getType() != CCSAction::RECV)
-            continue;
-        for(const CCSTransition& t2 : resr)
+    size_t c = out.size();
+    bounds.push_back(c);
+
+    //the receive transitions are bucketed by channel (name and parameter), chained through next,
+    //so every send transition only looks at the receives on its complementary channel
+    SyncIndex& index = syncIndex();
+    index.keys.resize(c - a);
+    index.next.resize(c - a);
+    index.comps.resize(c - a);
+    size_t recvs = 0;
+
+    for(size_t k = 0; k < ps.size(); k++)
+        for(size_t i = bounds[k]; i < bounds[k + 1]; i++)
         {
-            CCSAction act2 = t2.getAction();
-            if(!(act.getBase() == ~act2.getBase()))
+            CCSAction::Type type = out[i].act.getType();
+            if(type == CCSAction::DELTA)
                 continue;
+            if(type == CCSAction::RECV)
+                recvs++;
+            index.comps[i - a] = k;
+            out.emplace_back(out[i].act, nullptr, replace(k, out[i].to));
+        }
 
-            CCSAction* send = &act;
-            shared_ptr<CCSProcess> send_to = t.getTo();
-            CCSAction* recv = &act2;
-            shared_ptr<CCSProcess> recv_to = t2.getTo();
-
-            bool swap = false;
-            if(act.getType() == CCSAction::RECV)
+    if(recvs != 0)
+    {
+        size_t buckets = 4;
+        while(buckets < recvs * 2)
+            buckets *= 2;
+        index.heads.assign(buckets, npos);
+        for(size_t i = a; i < c; i++)
+            if(out[i].act.getType() == CCSAction::RECV)
             {
-                swap = true;
-                CCSAction* tmp = send;
-                send = recv;
-                recv = tmp;
-                send_to.swap(recv_to);
+                uint64_t key = channelKey(out[i].act, CCSAction::RECV);
+                size_t& head = index.heads[hash_mix(key) & (buckets - 1)];
+                index.keys[i - a] = key;
+                index.next[i - a] = head;
+                head = i;
             }
 
-            if(send->getExp() == nullptr && recv->getInput() == "" && recv->getExp() == nullptr)
-                ;//do nothing
-            else if(send->getExp() != nullptr && recv->getInput() != "")
-                recv_to = recv_to->subst(recv->getInput(), send->getExp()->eval());
-            else if(send->getExp() != nullptr && recv->getExp() != nullptr)
+        for(size_t i = a; i < c; i++)
+        {
+            if(out[i].act.getType() != CCSAction::SEND)
+                continue;
+            uint64_t key = channelKey(out[i].act, CCSAction::RECV);
+            for(size_t j = index.heads[hash_mix(key) & (buckets - 1)]; j != npos; j = index.next[j - a])
             {
-                if(send->getExp()->eval() != recv->getExp()->eval())
+                if(index.keys[j - a] != key || index.comps[j - a] == index.comps[i - a] || !out[i].act.isComplement(out[j].act))
                     continue;
-            }
-            else
-                continue;
 
-            if(swap)
-            {
-                CCSAction* tmp = send;
-                send = recv;
-                recv = tmp;
-                send_to.swap(recv_to);
-            }
+                const CCSAction& sact = out[i].act;
+                const CCSAction& ract = out[j].act;
+                CCSRef<CCSProcess> recv_to = out[j].to;
+
+                if(sact.getExp() == nullptr && ract.getInputId() == 0 && ract.getExp() == nullptr)
+                    ;//do nothing
+                else if(sact.getExp() != nullptr && ract.getInputId() != 0)
+                    recv_to = recv_to->subst(CCSEnv({ ract.getInputId() }, { sact.getExp()->eval() }));
+                else if(sact.getExp() != nullptr && ract.getExp() != nullptr)
+                {
+                    if(sact.getExp()->eval() != ract.getExp()->eval())
+                        continue;
+                }
+                else
+                    continue;
 
-            res.emplace(CCSAction(CCSAction::TAU), shared_from_this(),
-                make_shared<CCSParallel>(send_to, recv_to));
+                //emplace_back may reallocate out, so sact and ract must not be used afterwards
+                CCSRef<CCSProcess> to = replace(index.comps[i - a], out[i].to, index.comps[j - a], move(recv_to));
+                out.emplace_back(CCSAction(CCSAction::TAU), nullptr, move(to));
+            }
         }
     }
 
-    for(const CCSTransition& t : resl)
-        if(t.getAction().getType() == CCSAction::DELTA)
-        {
-            for(const CCSTransition& t2 : resr)
-                if(t2.getAction().getType() == CCSAction::DELTA)
-                {
-                    res.emplace(t.getAction(), shared_from_this(), make_shared<CCSParallel>(t.getTo(), t2.getTo()));
-                    break;
-                }
+    //all components have to terminate together
+    vector<CCSRef<CCSProcess>> term;
+    for(size_t k = 0; k < ps.size(); k++)
+    {
+        for(size_t i = bounds[k]; i < bounds[k + 1]; i++)
+            if(out[i].act.getType() == CCSAction::DELTA)
+            {
+                term.push_back(out[i].to);
+                break;
+            }
+        if(term.size() != k + 1)
             break;
-        }
+    }
+    if(term.size() == ps.size())
+        out.emplace_back(CCSAction(CCSAction::DELTA), nullptr, make_process<CCSParallel>(move(term)));
 
-    return res;
+    out.erase(out.begin() + a, out.begin() + c);
 }
 
-shared_ptr<CCSProcess> CCSParallel::subst(string id, int val, bool fold)
+CCSRef<CCSProcess> CCSParallel::substitute(const CCSEnv& env, bool fold)
 {
-    shared_ptr<CCSProcess> left2 = left->subst(id, val, fold);
-    shared_ptr<CCSProcess> right2 = right->subst(id, val, fold);
-    if(left2 == left && right2 == right)
-        return shared_from_this();
+    vector<CCSRef<CCSProcess>> ps2;
+    ps2.reserve(ps.size());
+    bool changed = false;
+    for(const CCSRef<CCSProcess>& p : ps)
+    {
+        ps2.push_back(p->subst(env, fold));
+        if(ps2.back() != p)
+            changed = true;
+    }
+    if(!changed)
+        return self();
     else
-        return make_shared<CCSParallel>(left2, right2);
+        return make_process<CCSParallel>(move(ps2));
 }
 
 void CCSParallel::print(ostream& out) const
 {
     out << "(";
-    left->print(out);
-    out << " | ";
-    right->print(out);
+    bool first = true;
+    for(const CCSRef<CCSProcess>& p : ps)
+    {
+        if(!first)
+            out << " | ";
+        first = false;
+        p->print(out);
+    }
     out << ")";
 }
 
@@ -429,60 +653,101 @@ void CCSParallel::accept(CCSVisitor<void>* v)
 
 
 
-CCSRestrict::CCSRestrict(shared_ptr<CCSProcess> p, set<CCSAction> r, bool complement)
-    :CCSProcess(RESTRICT), p(p), r(r), complement(complement)
-{}
+CCSRestrict::CCSRestrict(CCSRef<CCSProcess> p, set<CCSAction> r, bool complement)
+    :CCSProcess(RESTRICT), p(p)
+{
+    CCSRef<Restriction> res(new Restriction());
+    res->r = move(r);
+    res->complement = complement;
+    res->hash = hash_mix(complement);
+    for(const CCSAction& act : res->r)
+    {
+        res->hash = hash_combine(res->hash, act.getHash());
+        if(act.getParam() == nullptr && act.getInputId() == 0 && act.getExp() == nullptr)
+            res->keys.push_back(actionKey(act.getNameId(), act.getType()));
+    }
+    sort(res->keys.begin(), res->keys.end());
+    this->r = move(res);
+    hash = hash_combine(hash_combine(hash, p->hash), this->r->hash);
+    vars = p->vars;
+    foldable = p->foldable;
+}
+
+CCSRestrict::CCSRestrict(CCSRef<CCSProcess> p, const CCSRestrict& restrict)
+    :CCSProcess(RESTRICT), p(p), r(restrict.r)
+{
+    hash = hash_combine(hash_combine(hash, p->hash), r->hash);
+    vars = p->vars;
+    foldable = p->foldable;
+}
 
-shared_ptr<CCSProcess> CCSRestrict::getProcess() const
+bool CCSRestrict::restricts(const CCSAction& act) const
+{
+    //equivalent to r.count(act.getPlain()) || r.count(act.getNone())
+    const vector<uint64_t>& keys = r->keys;
+    return binary_search(keys.begin(), keys.end(), actionKey(act.getNameId(), act.getType())) ||
+        binary_search(keys.begin(), keys.end(), actionKey(act.getNameId(), CCSAction::NONE));
+}
+
+CCSRef<CCSProcess> CCSRestrict::getProcess() const
 { return p; }
 
 set<CCSAction> CCSRestrict::getR() const
-{ return r; }
+{ return r->r; }
 
 bool CCSRestrict::isComplement() const
-{ return complement; }
+{ return r->complement; }
+
+bool CCSRestrict::allows(const CCSAction& act) const
+{
+    if(act.getType() == CCSAction::TAU || act.getType() == CCSAction::DELTA)
+        return true;
+    return restricts(act) == r->complement;
+}
 
 int CCSRestrict::compare(const CCSProcess* p2) const
 {
     CCSRestrict* _p2 = (CCSRestrict*)p2;
     int c = p->compare(*_p2->p);
-    if(c != 0)
+    if(c != 0 || r == _p2->r)
         return c;
-    else if(complement < _p2->complement)
+    else if(r->complement < _p2->r->complement)
         return -1;
-    else if(complement > _p2->complement)
+    else if(r->complement > _p2->r->complement)
         return 1;
-    else if(r < _p2->r)
+    else if(r->r < _p2->r->r)
         return -1;
-    else if(r > _p2->r)
+    else if(r->r > _p2->r->r)
         return 1;
     return 0;
 }
 
-set<CCSTransition> CCSRestrict::getTransitions(CCSProgram& program, bool fold, set<string> seen)
+void CCSRestrict::collectTransitions(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
 {
-    set<CCSTransition> res;
-    for(const CCSTransition& t : p->getTransitions(program, fold, seen))
+    //filters the transitions of p in place
+    size_t a = out.size();
+    p->collectCached(program, fold, out, seen);
+    size_t w = a;
+    for(size_t i = a; i < out.size(); i++)
     {
-        CCSAction act = t.getAction();
-        if(act.getType() != CCSAction::TAU && act.getType() != CCSAction::DELTA)
-        {
-            bool inr = r.count(act.getPlain()) || r.count(act.getNone());
-            if(inr != complement)
-                continue;
-        }
-        res.emplace(act, shared_from_this(), make_shared<CCSRestrict>(t.getTo(), r, complement));
+        CCSTransition& t = out[i];
+        if(!allows(t.act))
+            continue;
+        t.to = make_process<CCSRestrict>(move(t.to), *this);
+        if(w != i)
+            out[w] = move(t);
+        w++;
     }
-    return res;
+    out.erase(out.begin() + w, out.end());
 }
 
-shared_ptr<CCSProcess> CCSRestrict::subst(string id, int val, bool fold)
+CCSRef<CCSProcess> CCSRestrict::substitute(const CCSEnv& env, bool fold)
 {
-    shared_ptr<CCSProcess> p2 = p->subst(id, val, fold);
+    CCSRef<CCSProcess> p2 = p->subst(env, fold);
     if(p2 == p)
-        return shared_from_this();
+        return self();
     else
-        return make_shared<CCSRestrict>(p2, r, complement);
+        return make_process<CCSRestrict>(p2, *this);
 }
 
 void CCSRestrict::print(ostream& out) const
@@ -491,17 +756,22 @@ void CCSRestrict::print(ostream& out) const
     p->print(out);
     out << "\\{";
     bool first = true;
-    if(complement)
+    if(r->complement)
     {
         out << "*";
         first = false;
     }
-    for(CCSAction act : r)
+    //r is ordered by interned ids, print the actions ordered by name
+    vector<string> acts;
+    for(const CCSAction& act : r->r)
+        acts.push_back((string)act);
+    sort(acts.begin(), acts.end());
+    for(const string& act : acts)
     {
         if(!first)
             out << ",";
         first = false;
-        act.print(out);
+        out << act;
     }
     out << "})";
 }
@@ -511,14 +781,18 @@ void CCSRestrict::accept(CCSVisitor<void>* v)
 
 
 
-CCSSequential::CCSSequential(shared_ptr<CCSProcess> left, shared_ptr<CCSProcess> right)
+CCSSequential::CCSSequential(CCSRef<CCSProcess> left, CCSRef<CCSProcess> right)
     :CCSProcess(SEQUENTIAL), left(left), right(right)
-{}
+{
+    hash = hash_combine(hash_combine(hash, left->hash), right->hash);
+    vars = left->vars | right->vars;
+    foldable = left->foldable || right->foldable;
+}
 
-shared_ptr<CCSProcess> CCSSequential::getLeft() const
+CCSRef<CCSProcess> CCSSequential::getLeft() const
 { return left; }
 
-shared_ptr<CCSProcess> CCSSequential::getRight() const
+CCSRef<CCSProcess> CCSSequential::getRight() const
 { return right; }
 
 int CCSSequential::compare(const CCSProcess* p2) const
@@ -530,27 +804,31 @@ int CCSSequential::compare(const CCSProcess* p2) const
     return right->compare(*_p2->right);
 }
 
-set<CCSTransition> CCSSequential::getTransitions(CCSProgram& program, bool fold, set<string> seen)
+void CCSSequential::collectTransitions(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
 {
-    set<CCSTransition> res;
-    for(CCSTransition t : left->getTransitions(program, fold, seen))
+    size_t a = out.size();
+    left->collectCached(program, fold, out, seen);
+    for(size_t i = a; i < out.size(); i++)
     {
-        if(t.getAction().getType() == CCSAction::DELTA)
-            res.emplace(CCSAction(CCSAction::TAU), shared_from_this(), right);
+        CCSTransition& t = out[i];
+        if(t.act.getType() == CCSAction::DELTA)
+        {
+            t.act = CCSAction(CCSAction::TAU);
+            t.to = right;
+        }
         else
-            res.emplace(t.getAction(), shared_from_this(), make_shared<CCSSequential>(t.getTo(), right));
+            t.to = make_process<CCSSequential>(move(t.to), right);
     }
-    return res;
 }
 
-shared_ptr<CCSProcess> CCSSequential::subst(string id, int val, bool fold)
+CCSRef<CCSProcess> CCSSequential::substitute(const CCSEnv& env, bool fold)
 {
-    shared_ptr<CCSProcess> left2 = left->subst(id, val, fold);
-    shared_ptr<CCSProcess> right2 = right->subst(id, val, fold);
+    CCSRef<CCSProcess> left2 = left->subst(env, fold);
+    CCSRef<CCSProcess> right2 = right->subst(env, fold);
     if(left2 == left && right2 == right)
-        return shared_from_this();
+        return self();
     else
-        return make_shared<CCSSequential>(left2, right2);
+        return make_process<CCSSequential>(left2, right2);
 }
 
 void CCSSequential::print(ostream& out) const
@@ -567,14 +845,18 @@ void CCSSequential::accept(CCSVisitor<void>* v)
 
 
 
-CCSWhen::CCSWhen(shared_ptr<CCSExp> cond, shared_ptr<CCSProcess> p)
+CCSWhen::CCSWhen(CCSRef<CCSExp> cond, CCSRef<CCSProcess> p)
     :CCSProcess(WHEN), cond(cond), p(p)
-{}
+{
+    hash = hash_combine(hash_combine(hash, cond->getHash()), p->hash);
+    vars = cond->getVars() | p->vars;
+    foldable = cond->isFoldable() || p->foldable;
+}
 
-shared_ptr<CCSExp> CCSWhen::getCond() const
+CCSRef<CCSExp> CCSWhen::getCond() const
 { return cond; }
 
-shared_ptr<CCSProcess> CCSWhen::getProcess() const
+CCSRef<CCSProcess> CCSWhen::getProcess() const
 { return p; }
 
 int CCSWhen::compare(const CCSProcess* p2) const
@@ -586,25 +868,20 @@ int CCSWhen::compare(const CCSProcess* p2) const
     return p->compare(*_p2->p);
 }
 
-set<CCSTransition> CCSWhen::getTransitions(CCSProgram& program, bool fold, set<string> seen)
+void CCSWhen::collectTransitions(CCSProgram& program, bool fold, vector<CCSTransition>& out, vector<uint32_t>& seen)
 {
-    if(!cond->eval())
-        return {};
-
-    set<CCSTransition> res;
-    for(CCSTransition t : p->getTransitions(program, fold, seen))
-        res.emplace(t.getAction(), shared_from_this(), t.getTo());
-    return res;
+    if(cond->eval())
+        p->collectCached(program, fold, out, seen);
 }
 
-shared_ptr<CCSProcess> CCSWhen::subst(string id, int val, bool fold)
+CCSRef<CCSProcess> CCSWhen::substitute(const CCSEnv& env, bool fold)
 {
-    shared_ptr<CCSExp> cond2 = cond->subst(id, val, fold);
-    shared_ptr<CCSProcess> p2 = p->subst(id, val, fold);
+    CCSRef<CCSExp> cond2 = cond->subst(env, fold);
+    CCSRef<CCSProcess> p2 = p->subst(env, fold);
     if(cond2 == cond && p2 == p)
-        return shared_from_this();
+        return self();
     else
-        return make_shared<CCSWhen>(cond2, p2);
+        return make_process<CCSWhen>(cond2, p2);
 }
 
 void CCSWhen::print(ostream& out) const
@@ -10,7 +10,7 @@
 namespace ccspp
 {
     /** @brief Represents a CCS process. */
-    class CCSProcess
+    class CCSProcess : public CCSRefCounted
     {
     public:
         /** @brief The type of the CCS process */
@@ -36,9 +36,16 @@ namespace ccspp
         friend class CCSRestrict;
         friend class CCSSequential;
         friend class CCSWhen;
+        friend class CCSUniqueTable<CCSProcess>;
 
     private:
         Type type;
+        uint64_t hash;
+        uint64_t vars;
+        bool interned;
+        bool foldable;
+
+        static CCSUniqueTable<CCSProcess>& uniqueTable();
 
     protected:
         /** @brief Internal comparison function.
@@ -46,15 +53,42 @@ namespace ccspp
         */
         virtual int compare(const CCSProcess* p) const = 0;
 
-        /** @brief Internal method to calculates all possible transition of that process. */
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen) = 0;
+        /** @brief Returns a reference to this process (which is owned by other references). */
+        CCSRef<CCSProcess> self()
+        { return CCSRef<CCSProcess>(this); }
+
+        /** @brief Internal method to calculate all possible transitions of that process.
+            Appends the transitions to out, without the left hand side (it is set by the public getTransitions)
+            and without removing duplicates.
+            @param seen The names of the processes instantiated on the current unguarded path.
+        */
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen) = 0;
+
+        /** @brief Like collectTransitions, but takes the transitions from the transition cache of the program if possible.
+            Operators use this to collect the transitions of their operands.
+        */
+        void collectCached(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+
+        /** @brief Internal substitution method.
+            Only called by subst if the process is affected by the substitution.
+        */
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold) = 0;
 
     public:
         /** @brief Constructor. */
         CCSProcess(Type type);
 
         /** @brief Destructor. */
-        virtual ~CCSProcess() = default;
+        virtual ~CCSProcess();
+
+        /** @brief Returns the canonical instance of a process.
+            All processes should be created with make_process, which calls this method,
+            so structurally equal processes are represented by the same object.
+        */
+        static CCSRef<CCSProcess> unique(CCSRef<CCSProcess> p);
+
+        /** @brief Returns the structural hash (computed once at construction). */
+        uint64_t getHash() const;
 
         /** @brief Returns the type of the process. */
         Type getType() const;
@@ -68,8 +102,40 @@ namespace ccspp
         */
         std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold = true);
 
+        /** @brief Calculates all possible transition of that process into a buffer.
+            This is the allocation-free variant of getTransitions for exploration loops:
+            out is cleared and filled with the transitions, sorted and without duplicates,
+            so reusing the same buffer for all states avoids allocations once it has grown.
+            If an exception is thrown, out is left empty.
+            @param program The CCSProgram of the process.
+            @param out The buffer for the transitions.
+            @param fold True if constant expression should be folded to constants.
+            @throws CCSRecursionException if there is an unguarded exception
+                leading to a recursion in transition inference.
+        */
+        void getTransitions(CCSProgram& program, std::vector<CCSTransition>& out, bool fold = true);
+
+        /** @brief Calculates the transitions of the process as a component of a parallel composition.
+            Unlike getTransitions, the transitions are neither sorted nor deduplicated, they are in the order
+            the parallel composition collects them, and receive transitions with an unbound input variable are kept.
+            If an exception is thrown, out is left empty.
+        */
+        void getLocalTransitions(CCSProgram& program, std::vector<CCSTransition>& out, bool fold = true);
+
+        /** @brief Returns the mask of the identifiers in the process (see CCSEnv). */
+        uint64_t getVars() const;
+
+        /** @brief Returns true if substitution with folding would fold a constant subexpression. */
+        bool isFoldable() const;
+
         /** @brief Substitutes an identifier by a value. */
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true) = 0;
+        CCSRef<CCSProcess> subst(std::string id, int val, bool fold = true);
+
+        /** @brief Substitutes all identifiers bound in env by their values in one pass.
+            Subprocesses that contain none of the identifiers (and nothing to fold) are not traversed.
+            Identifiers bound by an input prefix are not substituted in its continuation.
+        */
+        CCSRef<CCSProcess> subst(const CCSEnv& env, bool fold = true);
 
         /** @brief Prints the CCSProcess to an output stream. */
         virtual void print(std::ostream& out) const = 0;
@@ -89,182 +155,223 @@ namespace ccspp
         bool operator< (const CCSProcess& p) const;
     };
 
+    /** @brief Creates a hash-consed process.
+        Use this instead of new, so equal processes are the same object.
+        The process is allocated from the current CCSMemoryResource.
+    */
+    template<typename T, typename... Args>
+    CCSRef<T> make_process(Args&&... args)
+    { return static_ref_cast<T>(CCSProcess::unique(CCSRef<CCSProcess>(new T(std::forward<Args>(args)...)))); }
+
     /** @brief Prints a CCSProcess to an output stream */
     std::ostream& operator<< (std::ostream& out, const CCSProcess& p);
 
     /** @brief Represents the null process. */
-    class CCSNull : public CCSProcess, public std::enable_shared_from_this<CCSNull>
+    class CCSNull : public CCSProcess
     {
     protected:
         virtual int compare(const CCSProcess* p) const;
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen);
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold);
 
     public:
         CCSNull();
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true);
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSVisitor<void>* v);
     };
 
     /** @brief Represents the terminated process. */
-    class CCSTerm : public CCSProcess, public std::enable_shared_from_this<CCSTerm>
+    class CCSTerm : public CCSProcess
     {
     protected:
         virtual int compare(const CCSProcess* p) const;
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen);
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold);
 
     public:
         CCSTerm();
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true);
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSVisitor<void>* v);
     };
 
     /** @brief Represents a process instantiation. */
-    class CCSProcessName : public CCSProcess, public std::enable_shared_from_this<CCSProcessName>
+    class CCSProcessName : public CCSProcess
     {
     private:
-        std::string name;
-        std::vector<std::shared_ptr<CCSExp>> args;
+        uint32_t nameId;
+        std::vector<CCSRef<CCSExp>> args;
 
     protected:
         virtual int compare(const CCSProcess* p) const;
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen);
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold);
 
     public:
-        CCSProcessName(std::string name, std::vector<std::shared_ptr<CCSExp>> args);
-        std::string getName() const;
-        std::vector<std::shared_ptr<CCSExp>> getArgs();
+        CCSProcessName(std::string name, std::vector<CCSRef<CCSExp>> args);
+
+        /** @brief Constructs an instantiation of an interned name (see CCSSymbols), without looking it up. */
+        CCSProcessName(uint32_t nameId, std::vector<CCSRef<CCSExp>> args);
+
+        const std::string& getName() const;
+        uint32_t getNameId() const;
+        std::vector<CCSRef<CCSExp>> getArgs();
 
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true);
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSVisitor<void>* v);
     };
 
     /** @brief Represents a prefix process. */
-    class CCSPrefix : public CCSProcess, public std::enable_shared_from_this<CCSPrefix>
+    class CCSPrefix : public CCSProcess
     {
     private:
         CCSAction act;
-        std::shared_ptr<CCSProcess> p;
+        CCSRef<CCSProcess> p;
 
     protected:
         virtual int compare(const CCSProcess* p) const;
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen);
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold);
 
     public:
-        CCSPrefix(CCSAction act, std::shared_ptr<CCSProcess> p);
+        CCSPrefix(CCSAction act, CCSRef<CCSProcess> p);
         CCSAction getAction() const;
-        std::shared_ptr<CCSProcess> getProcess() const;
+        CCSRef<CCSProcess> getProcess() const;
 
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true);
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSVisitor<void>* v);
     };
 
     /** @brief Represents the choice operator. */
-    class CCSChoice : public CCSProcess, public std::enable_shared_from_this<CCSChoice>
+    class CCSChoice : public CCSProcess
     {
     private:
-        std::shared_ptr<CCSProcess> left;
-        std::shared_ptr<CCSProcess> right;
+        CCSRef<CCSProcess> left;
+        CCSRef<CCSProcess> right;
 
     protected:
         virtual int compare(const CCSProcess* p) const;
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen);
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold);
 
     public:
-        CCSChoice(std::shared_ptr<CCSProcess> left, std::shared_ptr<CCSProcess> right);
-        std::shared_ptr<CCSProcess> getLeft() const;
-        std::shared_ptr<CCSProcess> getRight() const;
+        CCSChoice(CCSRef<CCSProcess> left, CCSRef<CCSProcess> right);
+        CCSRef<CCSProcess> getLeft() const;
+        CCSRef<CCSProcess> getRight() const;
 
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true);
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSVisitor<void>* v);
     };
 
-    /** @brief Represents the parallel operator. */
-    class CCSParallel : public CCSProcess, public std::enable_shared_from_this<CCSParallel>
+    /** @brief Represents the parallel operator.
+        The parallel composition is n-ary: nested parallel compositions are flattened into one list of components,
+        so a transition only replaces the one or two components that take part in it.
+    */
+    class CCSParallel : public CCSProcess
     {
     private:
-        std::shared_ptr<CCSProcess> left;
-        std::shared_ptr<CCSProcess> right;
+        std::vector<CCSRef<CCSProcess>> ps;
+
+        /** @brief Returns this process with component i replaced by p. */
+        CCSRef<CCSProcess> replace(std::size_t i, CCSRef<CCSProcess> p) const;
+
+        /** @brief Returns this process with component i replaced by p and component j replaced by q. */
+        CCSRef<CCSProcess> replace(std::size_t i, CCSRef<CCSProcess> p, std::size_t j, CCSRef<CCSProcess> q) const;
 
     protected:
         virtual int compare(const CCSProcess* p) const;
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen);
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold);
 
     public:
-        CCSParallel(std::shared_ptr<CCSProcess> left, std::shared_ptr<CCSProcess> right);
-        std::shared_ptr<CCSProcess> getLeft() const;
-        std::shared_ptr<CCSProcess> getRight() const;
+        CCSParallel(CCSRef<CCSProcess> left, CCSRef<CCSProcess> right);
+        CCSParallel(std::vector<CCSRef<CCSProcess>> ps);
+
+        /** @brief Returns the components of the parallel composition (none of them is a CCSParallel). */
+        const std::vector<CCSRef<CCSProcess>>& getProcesses() const;
 
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true);
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSVisitor<void>* v);
     };
 
     /** @brief Represents the restriction operator. */
-    class CCSRestrict : public CCSProcess, public std::enable_shared_from_this<CCSRestrict>
+    class CCSRestrict : public CCSProcess
     {
     private:
-        std::shared_ptr<CCSProcess> p;
-        std::set<CCSAction> r;
-        bool complement;
+        /** @brief The restricted actions, shared by all successors of a restriction
+            (reference-counted like the terms, so copying it follows CCSRefCounted::setAtomic).
+        */
+        struct Restriction : public CCSRefCounted
+        {
+            std::set<CCSAction> r;
+            bool complement;
+            std::vector<uint64_t> keys; //sorted (name, type) keys of the plain actions in r
+            uint64_t hash;
+        };
+
+        CCSRef<CCSProcess> p;
+        CCSRef<const Restriction> r;
+
+        bool restricts(const CCSAction& act) const;
 
     protected:
         virtual int compare(const CCSProcess* p) const;
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen);
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold);
 
     public:
-        CCSRestrict(std::shared_ptr<CCSProcess> p, std::set<CCSAction> r, bool complement = false);
-        std::shared_ptr<CCSProcess> getProcess() const;
+        CCSRestrict(CCSRef<CCSProcess> p, std::set<CCSAction> r, bool complement = false);
+
+        /** @brief Constructs the restriction of p to the same actions as restrict (without copying them). */
+        CCSRestrict(CCSRef<CCSProcess> p, const CCSRestrict& restrict);
+        CCSRef<CCSProcess> getProcess() const;
         std::set<CCSAction> getR() const;
         bool isComplement() const;
 
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true);
+        /** @brief Returns true if a transition with the action is not removed by the restriction. */
+        bool allows(const CCSAction& act) const;
+
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSVisitor<void>* v);
     };
 
     /** @brief Represents the sequential operator. */
-    class CCSSequential : public CCSProcess, public std::enable_shared_from_this<CCSSequential>
+    class CCSSequential : public CCSProcess
     {
     private:
-        std::shared_ptr<CCSProcess> left;
-        std::shared_ptr<CCSProcess> right;
+        CCSRef<CCSProcess> left;
+        CCSRef<CCSProcess> right;
 
     protected:
         virtual int compare(const CCSProcess* p) const;
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen);
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold);
 
     public:
-        CCSSequential(std::shared_ptr<CCSProcess> left, std::shared_ptr<CCSProcess> right);
-        std::shared_ptr<CCSProcess> getLeft() const;
-        std::shared_ptr<CCSProcess> getRight() const;
+        CCSSequential(CCSRef<CCSProcess> left, CCSRef<CCSProcess> right);
+        CCSRef<CCSProcess> getLeft() const;
+        CCSRef<CCSProcess> getRight() const;
 
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true);
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSVisitor<void>* v);
     };
 
     /** @brief Represents the when operator. */
-    class CCSWhen : public CCSProcess, public std::enable_shared_from_this<CCSWhen>
+    class CCSWhen : public CCSProcess
     {
     private:
-        std::shared_ptr<CCSExp> cond;
-        std::shared_ptr<CCSProcess> p;
+        CCSRef<CCSExp> cond;
+        CCSRef<CCSProcess> p;
 
     protected:
         virtual int compare(const CCSProcess* p) const;
-        virtual std::set<CCSTransition> getTransitions(CCSProgram& program, bool fold, std::set<std::string> seen);
+        virtual void collectTransitions(CCSProgram& program, bool fold, std::vector<CCSTransition>& out, std::vector<uint32_t>& seen);
+        virtual CCSRef<CCSProcess> substitute(const CCSEnv& env, bool fold);
 
     public:
-        CCSWhen(std::shared_ptr<CCSExp> cond, std::shared_ptr<CCSProcess> p);
-        std::shared_ptr<CCSExp> getCond() const;
-        std::shared_ptr<CCSProcess> getProcess() const;
+        CCSWhen(CCSRef<CCSExp> cond, CCSRef<CCSProcess> p);
+        CCSRef<CCSExp> getCond() const;
+        CCSRef<CCSProcess> getProcess() const;
 
-        virtual std::shared_ptr<CCSProcess> subst(std::string id, int val, bool fold = true);
         virtual void print(std::ostream& out) const;
         virtual void accept(CCSVisitor<void>* v);
     };
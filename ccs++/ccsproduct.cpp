@@ -0,0 +1,1167 @@
+#include "ccsproduct.h"
+#include "ccsexternal.h"
+#include "ccsvisitor.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+
+using namespace std;
+using namespace ccspp;
+
+//checks that no parallel composition can be reached from a process
+class SequentialCheck : public CCSVisitor<bool>
+{
+private:
+    map<string, CCSBinding> bindings;
+    set<string> seen;
+
+public:
+    SequentialCheck(map<string, CCSBinding> bindings)
+        :bindings(move(bindings))
+    {}
+
+    virtual bool _visit(CCSNull* p)
+    { return true; }
+
+    virtual bool _visit(CCSTerm* p)
+    { return true; }
+
+    virtual bool _visit(CCSProcessName* p)
+    {
+        //a recursive name is sequential if its body is, which is checked by the outermost visit
+        if(!seen.insert(p->getName()).second)
+            return true;
+        auto it = bindings.find(p->getName());
+        return it == bindings.end() || vvisit(it->second.getProcess());
+    }
+
+    virtual bool _visit(CCSPrefix* p)
+    { return vvisit(p->getProcess()); }
+
+    virtual bool _visit(CCSChoice* p)
+    { return vvisit(p->getLeft()) && vvisit(p->getRight()); }
+
+    virtual bool _visit(CCSParallel* p)
+    { return false; }
+
+    virtual bool _visit(CCSRestrict* p)
+    { return vvisit(p->getProcess()); }
+
+    virtual bool _visit(CCSSequential* p)
+    { return vvisit(p->getLeft()) && vvisit(p->getRight()); }
+
+    virtual bool _visit(CCSWhen* p)
+    { return vvisit(p->getProcess()); }
+};
+
+//collects the actions of all prefixes that can be reached from a process
+class ChannelCollector : public CCSVisitor<void>
+{
+private:
+    map<string, CCSBinding> bindings;
+    set<string> seen;
+
+public:
+    set<pair<uint32_t, CCSAction::Type>> actions;
+
+    using CCSVisitor<void>::visit;
+
+    ChannelCollector(map<string, CCSBinding> bindings)
+        :bindings(move(bindings))
+    {}
+
+    virtual void visit(CCSNull* p)
+    {}
+
+    virtual void visit(CCSTerm* p)
+    {}
+
+    virtual void visit(CCSProcessName* p)
+    {
+        if(!seen.insert(p->getName()).second)
+            return;
+        auto it = bindings.find(p->getName());
+        if(it != bindings.end())
+            visit(it->second.getProcess());
+    }
+
+    virtual void visit(CCSPrefix* p)
+    {
+        const CCSAction& act = p->getAction();
+        if(act.getNameId() != 0)
+            actions.insert({ act.getNameId(), act.getType() });
+        visit(p->getProcess());
+    }
+
+    virtual void visit(CCSChoice* p)
+    {
+        visit(p->getLeft());
+        visit(p->getRight());
+    }
+
+    virtual void visit(CCSParallel* p)
+    {
+        for(const CCSRef<CCSProcess>& q : p->getProcesses())
+            visit(q);
+    }
+
+    virtual void visit(CCSRestrict* p)
+    { visit(p->getProcess()); }
+
+    virtual void visit(CCSSequential* p)
+    {
+        visit(p->getLeft());
+        visit(p->getRight());
+    }
+
+    virtual void visit(CCSWhen* p)
+    { visit(p->getProcess()); }
+};
+
+static bool isNetwork(const CCSRef<CCSProcess>& p, SequentialCheck& check)
+{
+    if(p->getType() == CCSProcess::PARALLEL)
+    {
+        for(const CCSRef<CCSProcess>& q : static_cast<CCSParallel*>(p.get())->getProcesses())
+            if(!isNetwork(q, check))
+                return false;
+        return true;
+    }
+    else if(p->getType() == CCSProcess::RESTRICT)
+        return isNetwork(static_cast<CCSRestrict*>(p.get())->getProcess(), check);
+    else
+        return check.vvisit(p);
+}
+
+
+
+CCSProductExplorer::CCSProductExplorer(CCSProgram& program, bool fold)
+    :program(program), fold(fold), budget(nullptr), reduction(NO_REDUCTION), symmetric(false), states(0)
+{
+    if(program.getNormalizer())
+        throw CCSException("the product of the components cannot be explored with normalized states");
+    build(program.getProcess());
+    //every component starts in its first local state
+    states = CCSTreeTable(comps.size());
+    vector<uint32_t> start(comps.size(), 0);
+    states.insert(start.data());
+}
+
+bool CCSProductExplorer::isNetwork(const CCSProgram& program)
+{
+    SequentialCheck check(program.getBindings());
+    return ::isNetwork(program.getProcess(), check);
+}
+
+size_t CCSProductExplorer::getComponents() const
+{ return comps.size(); }
+
+void CCSProductExplorer::setBudget(CCSBudget* budget)
+{ this->budget = budget; }
+
+void CCSProductExplorer::setReduction(Reduction reduction)
+{
+    this->reduction = reduction;
+    if(reduction == NO_REDUCTION || !users.empty())
+        return;
+    //the name id 0 is not used, so the table is not empty after the analysis
+    users.resize(1);
+    vector<const CCSRestrict*> restricts;
+    analyze(0, restricts);
+}
+
+void CCSProductExplorer::analyze(size_t node, vector<const CCSRestrict*>& restricts)
+{
+    const Node& n = nodes[node];
+    if(n.process->getType() == CCSProcess::RESTRICT)
+    {
+        restricts.push_back(static_cast<CCSRestrict*>(n.process.get()));
+        analyze(n.children[0], restricts);
+        restricts.pop_back();
+        return;
+    }
+    else if(n.process->getType() == CCSProcess::PARALLEL)
+    {
+        for(size_t child : n.children)
+            analyze(child, restricts);
+        return;
+    }
+
+    //restrictions within a component are ignored, so a component may be visible although it is not
+    Component& c = comps[n.first];
+    ChannelCollector collector(program.getBindings());
+    collector.visit(c.states[0].process);
+    c.visible = false;
+    for(const pair<uint32_t, CCSAction::Type>& act : collector.actions)
+    {
+        if(users.size() <= act.first)
+            users.resize(act.first + 1);
+        if(users[act.first].empty() || users[act.first].back() != n.first)
+            users[act.first].push_back(n.first);
+
+        CCSAction a(act.second, CCSSymbols::name(act.first));
+        bool allowed = true;
+        for(const CCSRestrict* r : restricts)
+            allowed = allowed && r->allows(a);
+        c.visible = c.visible || allowed;
+    }
+}
+
+//key of the channel (name and parameter) of a send or receive action, like in CCSParallel
+static uint64_t channelKey(const CCSAction& act)
+{
+    uint64_t key = act.getNameId();
+    return act.getParam() == nullptr ? key : hash_combine(key, act.getParam()->getHash());
+}
+
+static const size_t npos = -1;
+static const uint32_t noImage = -1;
+static const size_t maxSymmetries = 1 << 16;
+
+static string print(const CCSProcess& p)
+{
+    ostringstream out;
+    out << p;
+    return out.str();
+}
+
+static map<uint32_t, uint32_t> compose(const map<uint32_t, uint32_t>& p1, const map<uint32_t, uint32_t>& p2)
+{
+    //p1 after p2, without the names mapped to themselves
+    map<uint32_t, uint32_t> res;
+    for(const pair<const uint32_t, uint32_t>& e : p2)
+    {
+        auto it = p1.find(e.second);
+        uint32_t to = it == p1.end() ? e.second : it->second;
+        if(to != e.first)
+            res[e.first] = to;
+    }
+    for(const pair<const uint32_t, uint32_t>& e : p1)
+        if(!p2.count(e.first))
+            res.insert(e);
+    return res;
+}
+
+void CCSProductExplorer::setSymmetry(const vector<map<uint32_t, uint32_t>>& permutations)
+{
+    symmetric = true;
+    groups.clear();
+    symmetries.clear();
+
+    //the siblings of every component (the components in the same parallel composition)
+    vector<vector<size_t>> siblings(comps.size());
+    for(size_t k = 0; k < comps.size(); k++)
+        siblings[k] = { k };
+    for(const Node& n : nodes)
+    {
+        if(n.process->getType() != CCSProcess::PARALLEL)
+            continue;
+        vector<size_t> leaves;
+        for(size_t child : n.children)
+            if(nodes[child].process->getType() != CCSProcess::PARALLEL && nodes[child].process->getType() != CCSProcess::RESTRICT)
+                leaves.push_back(nodes[child].first);
+        for(size_t k : leaves)
+            siblings[k] = leaves;
+
+        vector<bool> grouped(leaves.size());
+        for(size_t i = 0; i < leaves.size(); i++)
+        {
+            if(grouped[i])
+                continue;
+            vector<size_t> group{ leaves[i] };
+            for(size_t j = i + 1; j < leaves.size(); j++)
+                if(!grouped[j] && comps[leaves[j]].states[0].process == comps[leaves[i]].states[0].process)
+                {
+                    grouped[j] = true;
+                    group.push_back(leaves[j]);
+                }
+            if(group.size() > 1)
+                groups.push_back(move(group));
+        }
+    }
+
+    //the group generated by the permutations, without the identity
+    set<map<uint32_t, uint32_t>> elements;
+    vector<map<uint32_t, uint32_t>> queue;
+    for(const map<uint32_t, uint32_t>& p : permutations)
+    {
+        map<uint32_t, uint32_t> q = compose(p, {});
+        if(elements.insert(q).second)
+            queue.push_back(move(q));
+    }
+    for(size_t i = 0; i < queue.size(); i++)
+        for(const map<uint32_t, uint32_t>& p : permutations)
+        {
+            map<uint32_t, uint32_t> q = compose(p, queue[i]);
+            if(elements.insert(q).second)
+            {
+                if(elements.size() > maxSymmetries)
+                    throw CCSException("the channel permutations generate too many symmetries");
+                queue.push_back(move(q));
+            }
+        }
+    elements.erase(map<uint32_t, uint32_t>());
+
+    //a name that is not an action of the program is most likely misspelled
+    ChannelCollector collector(program.getBindings());
+    collector.visit(program.getProcess());
+    set<uint32_t> used;
+    for(const pair<uint32_t, CCSAction::Type>& act : collector.actions)
+        used.insert(act.first);
+    for(const map<uint32_t, uint32_t>& p : permutations)
+        for(const pair<const uint32_t, uint32_t>& e : p)
+            if(!used.count(e.first))
+                throw CCSException("the channel permutation renames " + CCSSymbols::name(e.first) + ", which is not an action of the program");
+
+    for(const map<uint32_t, uint32_t>& element : elements)
+    {
+        symmetries.push_back(Symmetry{ CCSChannelPermutation(program, element), vector<size_t>(comps.size()), {} });
+        Symmetry& sym = symmetries.back();
+        sym.images.resize(comps.size());
+        for(const Node& n : nodes)
+        {
+            if(n.process->getType() != CCSProcess::RESTRICT)
+                continue;
+            const CCSRestrict& r = *static_cast<CCSRestrict*>(n.process.get());
+            for(const pair<const uint32_t, uint32_t>& e : element)
+                for(CCSAction::Type type : { CCSAction::NONE, CCSAction::SEND, CCSAction::RECV })
+                    if(r.allows(CCSAction(type, CCSSymbols::name(e.first))) != r.allows(CCSAction(type, CCSSymbols::name(e.second))))
+                        throw CCSException("the channel permutation does not keep the restriction " + print(r));
+        }
+
+        //every component is mapped to the first free sibling with the image of its process
+        vector<bool> taken(comps.size());
+        for(size_t k = 0; k < comps.size(); k++)
+        {
+            bool found = false;
+            for(size_t j : siblings[k])
+                if(!taken[j] && sym.perm.match(comps[k].states[0].process, comps[j].states[0].process))
+                {
+                    taken[j] = true;
+                    sym.comps[k] = j;
+                    found = true;
+                    break;
+                }
+            if(!found)
+                throw CCSException("the channel permutation does not map the component " + print(*comps[k].states[0].process) +
+                    " to another component");
+        }
+    }
+}
+
+uint32_t CCSProductExplorer::image(Symmetry& sym, size_t comp, uint32_t id)
+{
+    vector<uint32_t>& images = sym.images[comp];
+    if(images.size() <= id)
+        images.resize(comps[comp].states.size(), noImage);
+    if(images[id] == noImage)
+    {
+        CCSRef<CCSProcess> p = sym.perm.apply(comps[comp].states[id].process);
+        images[id] = intern(sym.comps[comp], p);
+    }
+    return images[id];
+}
+
+void CCSProductExplorer::sortGroups(uint32_t* state)
+{
+    //the ids of the local states differ between the components, so the terms are sorted
+    vector<CCSRef<CCSProcess>> ps;
+    for(const vector<size_t>& group : groups)
+    {
+        ps.clear();
+        for(size_t k : group)
+            ps.push_back(comps[k].states[state[k]].process);
+        sort(ps.begin(), ps.end(), [](const CCSRef<CCSProcess>& p1, const CCSRef<CCSProcess>& p2)
+            { return p1->compare(*p2) < 0; });
+        for(size_t i = 0; i < group.size(); i++)
+            state[group[i]] = intern(group[i], ps[i]);
+    }
+}
+
+void CCSProductExplorer::canonicalize(uint32_t* state)
+{
+    sortGroups(state);
+    if(symmetries.empty())
+        return;
+
+    //the images of the representative are the images of the state with sorted groups, so any fixed order of the vectors works;
+    //the terms are compared instead of the ids, so the representatives do not depend on the order the local states are found in
+    size_t n = comps.size();
+    vector<uint32_t> best(state, state + n);
+    vector<uint32_t> v(n);
+    for(Symmetry& sym : symmetries)
+    {
+        for(size_t k = 0; k < n; k++)
+            v[sym.comps[k]] = image(sym, k, state[k]);
+        sortGroups(v.data());
+        if(compare(v.data(), best.data()) < 0)
+            best = v;
+    }
+    copy(best.begin(), best.end(), state);
+}
+
+void CCSProductExplorer::vectorize(size_t node, const CCSRef<CCSProcess>& p, uint32_t* state)
+{
+    //the terms of the states have the structure of the nodes (see term)
+    const Node& n = nodes[node];
+    if(n.process->getType() == CCSProcess::RESTRICT)
+        vectorize(n.children[0], static_cast<CCSRestrict*>(p.get())->getProcess(), state);
+    else if(n.process->getType() == CCSProcess::PARALLEL)
+    {
+        const vector<CCSRef<CCSProcess>>& ps = static_cast<CCSParallel*>(p.get())->getProcesses();
+        for(size_t k = 0; k < n.children.size(); k++)
+            vectorize(n.children[k], ps[k], state);
+    }
+    else
+        state[n.first] = intern(n.first, p);
+}
+
+CCSTransition CCSProductExplorer::lift(const CCSRef<CCSProcess>& from, size_t to)
+{
+    size_t n = comps.size();
+    vector<uint32_t> state(n);
+    vector<uint32_t> rep(n);
+    vector<uint32_t> target(n);
+    vector<uint32_t> canonical(n);
+    vectorize(0, from, state.data());
+    states.get(to, rep.data());
+
+    //moves and changes are only used by successors until the transitions of the explored state are built
+    moves.clear();
+    changes.clear();
+    collect(0, state.data());
+    for(const Move& m : moves)
+    {
+        apply(m, state.data(), target.data());
+        canonical = target;
+        if(symmetric)
+            canonicalize(canonical.data());
+        if(canonical == rep)
+            return CCSTransition(m.act, from, term(0, target.data()));
+    }
+    throw CCSException("no transition from " + print(*from) + " to a state with the representative " + print(*term(0, rep.data())));
+}
+
+size_t CCSProductExplorer::size() const
+{ return states.size(); }
+
+size_t CCSProductExplorer::getMemory() const
+{ return states.getMemory(); }
+
+size_t CCSProductExplorer::build(const CCSRef<CCSProcess>& p)
+{
+    size_t node = nodes.size();
+    nodes.push_back(Node{ p, {}, comps.size(), 0 });
+    if(p->getType() == CCSProcess::PARALLEL)
+        for(const CCSRef<CCSProcess>& q : static_cast<CCSParallel*>(p.get())->getProcesses())
+        {
+            size_t child = build(q);
+            nodes[node].children.push_back(child);
+        }
+    else if(p->getType() == CCSProcess::RESTRICT)
+    {
+        size_t child = build(static_cast<CCSRestrict*>(p.get())->getProcess());
+        nodes[node].children.push_back(child);
+    }
+    else
+    {
+        comps.emplace_back();
+        intern(comps.size() - 1, p);
+    }
+    nodes[node].last = comps.size();
+    return node;
+}
+
+uint32_t CCSProductExplorer::intern(size_t comp, const CCSRef<CCSProcess>& p)
+{
+    Component& c = comps[comp];
+    uint32_t id = c.states.size();
+    pair<uint32_t*, bool> ins = c.ids.insert(p, id);
+    if(!ins.second)
+        return *ins.first;
+    c.states.push_back(Local{ p, false, nullptr, {} });
+    return id;
+}
+
+const CCSProductExplorer::Local& CCSProductExplorer::local(size_t comp, uint32_t id)
+{
+    vector<Local>& states = comps[comp].states;
+    if(!states[id].computed)
+    {
+        states[id].computed = true;
+        try
+        {
+            states[id].process->getLocalTransitions(program, scratch, fold);
+        }
+        catch(CCSException& ex)
+        {
+            states[id].error = current_exception();
+        }
+        //intern may add local states, so states[id] has to be looked up again every time
+        for(const CCSTransition& t : scratch)
+        {
+            uint32_t target = intern(comp, t.getTo());
+            states[id].moves.push_back({ t.getAction(), target });
+        }
+    }
+    return states[id];
+}
+
+void CCSProductExplorer::collect(size_t node, const uint32_t* state)
+{
+    //mirrors CCSProcess::getLocalTransitions of the term of the node, see CCSParallel and CCSRestrict
+    const Node& n = nodes[node];
+    if(n.process->getType() == CCSProcess::RESTRICT)
+    {
+        const CCSRestrict& r = *static_cast<CCSRestrict*>(n.process.get());
+        size_t a = moves.size();
+        collect(n.children[0], state);
+        size_t w = a;
+        for(size_t i = a; i < moves.size(); i++)
+            if(r.allows(moves[i].act))
+            {
+                if(w != i)
+                    moves[w] = move(moves[i]);
+                w++;
+            }
+        moves.erase(moves.begin() + w, moves.end());
+        return;
+    }
+    else if(n.process->getType() != CCSProcess::PARALLEL)
+    {
+        const Local& l = local(n.first, state[n.first]);
+        if(l.error)
+            rethrow_exception(l.error);
+        for(const LocalMove& m : l.moves)
+        {
+            changes.push_back({ n.first, m.target });
+            moves.push_back({ m.act, changes.size() - 1, changes.size() });
+        }
+        return;
+    }
+
+    size_t a = moves.size();
+    vector<size_t> bounds;
+    bounds.reserve(n.children.size() + 1);
+    for(size_t child : n.children)
+    {
+        bounds.push_back(moves.size());
+        collect(child, state);
+    }
+    size_t c = moves.size();
+    bounds.push_back(c);
+
+    vector<size_t> owner(c - a);
+    size_t recvs = 0;
+    for(size_t k = 0; k < n.children.size(); k++)
+        for(size_t i = bounds[k]; i < bounds[k + 1]; i++)
+        {
+            owner[i - a] = k;
+            if(moves[i].act.getType() == CCSAction::RECV)
+                recvs++;
+            if(moves[i].act.getType() != CCSAction::DELTA)
+            {
+                Move m = moves[i];
+                moves.push_back(move(m));
+            }
+        }
+
+    //the children are collected before the index is filled, so the nodes below do not interfere with it
+    size_t buckets = 4;
+    while(buckets < recvs * 2)
+        buckets *= 2;
+    if(recvs != 0)
+    {
+        recvHeads.assign(buckets, npos);
+        recvNext.resize(c - a);
+        recvKeys.resize(c - a);
+        for(size_t i = a; i < c; i++)
+            if(moves[i].act.getType() == CCSAction::RECV)
+            {
+                uint64_t key = channelKey(moves[i].act);
+                size_t& head = recvHeads[hash_mix(key) & (buckets - 1)];
+                recvKeys[i - a] = key;
+                recvNext[i - a] = head;
+                head = i;
+            }
+    }
+
+    //receives are matched in the same order as by CCSParallel (the chains are in reverse order),
+    //so expression errors are reported the same way
+    for(size_t i = a; i < c && recvs != 0; i++)
+    {
+        if(moves[i].act.getType() != CCSAction::SEND)
+            continue;
+        uint64_t key = channelKey(moves[i].act);
+        for(size_t j = recvHeads[hash_mix(key) & (buckets - 1)]; j != npos; j = recvNext[j - a])
+        {
+            if(recvKeys[j - a] != key || owner[j - a] == owner[i - a] || !moves[i].act.isComplement(moves[j].act))
+                continue;
+
+            const CCSAction& sact = moves[i].act;
+            const CCSAction& ract = moves[j].act;
+            bool input = false;
+            int value = 0;
+            if(sact.getExp() == nullptr && ract.getInputId() == 0 && ract.getExp() == nullptr)
+                ;//do nothing
+            else if(sact.getExp() != nullptr && ract.getInputId() != 0)
+            {
+                input = true;
+                value = sact.getExp()->eval();
+            }
+            else if(sact.getExp() != nullptr && ract.getExp() != nullptr)
+            {
+                if(sact.getExp()->eval() != ract.getExp()->eval())
+                    continue;
+            }
+            else
+                continue;
+
+            size_t begin = changes.size();
+            for(size_t k = moves[i].begin; k < moves[i].end; k++)
+                changes.push_back(changes[k]);
+            if(!input)
+                for(size_t k = moves[j].begin; k < moves[j].end; k++)
+                    changes.push_back(changes[k]);
+            else
+            {
+                //the value is substituted in the whole receiving operand, like in its term
+                CCSEnv env({ ract.getInputId() }, { value });
+                const Node& recv = nodes[n.children[owner[j - a]]];
+                for(size_t comp = recv.first; comp < recv.last; comp++)
+                {
+                    uint32_t id = state[comp];
+                    for(size_t k = moves[j].begin; k < moves[j].end; k++)
+                        if(changes[k].comp == comp)
+                            id = changes[k].local;
+                    CCSRef<CCSProcess> p = comps[comp].states[id].process;
+                    CCSRef<CCSProcess> q = p->subst(env);
+                    if(q != p)
+                        id = intern(comp, q);
+                    if(id != state[comp])
+                        changes.push_back({ comp, id });
+                }
+            }
+            moves.push_back({ CCSAction(CCSAction::TAU), begin, changes.size() });
+        }
+    }
+
+    //all components have to terminate together
+    size_t begin = changes.size();
+    size_t term = 0;
+    for(size_t k = 0; k < n.children.size(); k++)
+    {
+        for(size_t i = bounds[k]; i < bounds[k + 1]; i++)
+            if(moves[i].act.getType() == CCSAction::DELTA)
+            {
+                for(size_t l = moves[i].begin; l < moves[i].end; l++)
+                    changes.push_back(changes[l]);
+                term++;
+                break;
+            }
+        if(term != k + 1)
+            break;
+    }
+    if(term == n.children.size())
+        moves.push_back({ CCSAction(CCSAction::DELTA), begin, changes.size() });
+    else
+        changes.resize(begin);
+
+    moves.erase(moves.begin() + a, moves.begin() + c);
+}
+
+void CCSProductExplorer::apply(const Move& m, const uint32_t* state, uint32_t* out) const
+{
+    copy(state, state + comps.size(), out);
+    for(size_t k = m.begin; k < m.end; k++)
+        out[changes[k].comp] = changes[k].local;
+}
+
+CCSRef<CCSProcess> CCSProductExplorer::term(size_t node, const uint32_t* state) const
+{
+    const Node& n = nodes[node];
+    if(n.process->getType() == CCSProcess::RESTRICT)
+        return make_process<CCSRestrict>(term(n.children[0], state), *static_cast<CCSRestrict*>(n.process.get()));
+    else if(n.process->getType() != CCSProcess::PARALLEL)
+        return comps[n.first].states[state[n.first]].process;
+
+    vector<CCSRef<CCSProcess>> ps;
+    ps.reserve(n.children.size());
+    for(size_t child : n.children)
+        ps.push_back(term(child, state));
+    return make_process<CCSParallel>(move(ps));
+}
+
+CCSRef<CCSProcess> CCSProductExplorer::term(uint32_t id)
+{
+    vector<uint32_t> state(comps.size());
+    states.get(id, state.data());
+    return term(0, state.data());
+}
+
+int CCSProductExplorer::compare(const uint32_t* s1, const uint32_t* s2) const
+{
+    //the terms of two global states differ only in the components, which are compared in the same order
+    for(size_t k = 0; k < comps.size(); k++)
+        if(s1[k] != s2[k])
+            return comps[k].states[s1[k]].process->compare(*comps[k].states[s2[k]].process);
+    return 0;
+}
+
+bool CCSProductExplorer::reduce(const uint32_t* state)
+{
+    //a termination synchronizes all components, so it is not postponed
+    size_t n = comps.size();
+    for(size_t k = 0; k < n; k++)
+        for(const LocalMove& m : comps[k].states[state[k]].moves)
+            if(m.act.getType() == CCSAction::DELTA)
+                return false;
+
+    vector<bool> best;
+    size_t bestSize = moves.size();
+    vector<bool> in(n);
+    vector<size_t> stack;
+    auto add = [&](size_t k)
+    {
+        if(!in[k])
+        {
+            in[k] = true;
+            stack.push_back(k);
+        }
+    };
+    for(size_t seed = 0; seed < n; seed++)
+    {
+        //only a component with an enabled transition is a seed, so the set is never empty
+        bool enabled = false;
+        for(const Move& m : moves)
+            for(size_t i = m.begin; i < m.end; i++)
+                enabled = enabled || changes[i].comp == seed;
+        if(!enabled)
+            continue;
+
+        fill(in.begin(), in.end(), false);
+        add(seed);
+        for(bool closed = false; !closed;)
+        {
+            //the components that may ever take part in an action of the current local states of the set
+            while(!stack.empty())
+            {
+                size_t k = stack.back();
+                stack.pop_back();
+                for(const LocalMove& m : comps[k].states[state[k]].moves)
+                    if(m.act.getNameId() != 0)
+                        for(size_t user : users[m.act.getNameId()])
+                            add(user);
+            }
+
+            //the enabled transitions changing a component of the set (a received value may change several components),
+            //and all components that may perform visible actions if one of them is visible
+            closed = true;
+            bool visible = false;
+            for(const Move& m : moves)
+            {
+                bool touches = false;
+                for(size_t i = m.begin; i < m.end; i++)
+                    touches = touches || in[changes[i].comp];
+                if(!touches)
+                    continue;
+                visible = visible || m.act.getType() != CCSAction::TAU;
+                for(size_t i = m.begin; i < m.end; i++)
+                    add(changes[i].comp);
+            }
+            if(visible && reduction == PRESERVE_ACTIONS)
+                for(size_t k = 0; k < n; k++)
+                    if(comps[k].visible)
+                        add(k);
+            closed = stack.empty();
+        }
+
+        size_t size = 0;
+        for(const Move& m : moves)
+            if(in[changes[m.begin].comp])
+                size++;
+        if(size < bestSize)
+        {
+            best = in;
+            bestSize = size;
+        }
+    }
+    if(best.empty())
+        return false;
+
+    size_t w = 0;
+    for(size_t i = 0; i < moves.size(); i++)
+        if(best[changes[moves[i].begin].comp])
+        {
+            if(w != i)
+                moves[w] = move(moves[i]);
+            w++;
+        }
+    moves.erase(moves.begin() + w, moves.end());
+    return true;
+}
+
+bool CCSProductExplorer::successors(const uint32_t* state, CCSExplorer::State& s, vector<uint32_t>& out, bool reduced)
+{
+    size_t n = comps.size();
+    moves.clear();
+    changes.clear();
+    s.trans.clear();
+    s.targets.clear();
+    s.error = false;
+    s.message.clear();
+    out.clear();
+
+    vector<uint32_t> targets;
+    try
+    {
+        collect(0, state);
+        if(reduced)
+            reduced = reduce(state);
+        targets.resize(moves.size() * n);
+        for(size_t i = 0; i < moves.size(); i++)
+        {
+            apply(moves[i], state, &targets[i * n]);
+            if(moves[i].act.getInputId() != 0)
+                throw CCSProcessException(term(0, &targets[i * n]), "unrestricted input variable `" + moves[i].act.getInput() + "`");
+        }
+        //the representatives are computed before the transitions are deduplicated, so symmetric transitions are merged
+        if(symmetric)
+            for(size_t i = 0; i < moves.size(); i++)
+                canonicalize(&targets[i * n]);
+    }
+    catch(CCSException& ex)
+    {
+        s.error = true;
+        s.message = ex.what();
+        return false;
+    }
+
+    //sorted and deduplicated like the transitions of the term
+    vector<size_t> order(moves.size());
+    for(size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    sort(order.begin(), order.end(), [&](size_t i, size_t j)
+    {
+        int c = moves[i].act.compare(moves[j].act);
+        return c != 0 ? c < 0 : compare(&targets[i * n], &targets[j * n]) < 0;
+    });
+
+    for(size_t k = 0; k < order.size(); k++)
+    {
+        size_t i = order[k];
+        if(k > 0 && moves[i].act == moves[order[k - 1]].act &&
+                memcmp(&targets[i * n], &targets[order[k - 1] * n], n * sizeof(uint32_t)) == 0)
+            continue;
+
+        //of merged transitions, the first is kept, since every one of them leads to the representative
+        s.trans.emplace_back(moves[i].act, s.process, nullptr);
+        out.insert(out.end(), &targets[i * n], &targets[i * n] + n);
+    }
+    return reduced;
+}
+
+void CCSProductExplorer::expand(uint32_t id, CCSExplorer::State& s, vector<uint32_t>& targets)
+{
+    size_t n = comps.size();
+    vector<uint32_t> state(n);
+    states.get(id, state.data());
+    if(successors(state.data(), s, targets, reduction != NO_REDUCTION) && reduction == PRESERVE_ACTIONS)
+    {
+        //a postponed transition could be ignored forever on a cycle, so states with a transition to a known state are
+        //explored fully (all states found so far, which is stronger than the states on the stack of a depth-first search)
+        for(size_t i = 0; i < s.trans.size(); i++)
+            if(states.find(&targets[i * n]).second)
+            {
+                successors(state.data(), s, targets);
+                break;
+            }
+    }
+    for(size_t i = 0; i < s.trans.size(); i++)
+        s.targets.push_back(states.insert(&targets[i * n]).first);
+}
+
+bool CCSProductExplorer::visit(const CCSExplorer::State& s, const vector<uint32_t>& targets, size_t& discoveredId,
+    const vector<CCSExplorer::Observer*>& observers, bool keep)
+{
+    for(CCSExplorer::Observer* o : observers)
+        o->state(s);
+    if(s.error)
+    {
+        for(CCSExplorer::Observer* o : observers)
+            if(!o->error(s))
+                return false;
+    }
+    else if(s.trans.empty())
+        for(CCSExplorer::Observer* o : observers)
+            o->deadlock(s);
+
+    for(size_t i = 0; i < s.trans.size(); i++)
+    {
+        for(CCSExplorer::Observer* o : observers)
+            o->transition(s, i);
+        //the ids are assigned in the order of discovery, so a target is new iff it has the next id
+        if(s.targets[i] == discoveredId)
+        {
+            discoveredId++;
+            CCSRef<CCSProcess> p = term(0, &targets[i * comps.size()]);
+            for(CCSExplorer::Observer* o : observers)
+                o->discovered(s.targets[i], p, &s, i);
+            if(keep)
+                frontier.push_back(move(p));
+        }
+    }
+    return true;
+}
+
+bool CCSProductExplorer::explore(int maxDepth, const vector<CCSExplorer::Observer*>& observers)
+{
+    CCSRef<CCSProcess> start = program.getProcess();
+    frontier.push_back(start);
+    for(CCSExplorer::Observer* o : observers)
+        o->discovered(0, start, nullptr, 0);
+
+    CCSExplorer::State s;
+    vector<uint32_t> targets;
+    size_t discoveredId = 1;
+    size_t next = 0;
+    size_t layerEnd = 1;
+    for(int depth = 0; next < states.size(); next++)
+    {
+        if(next == layerEnd)
+        {
+            depth++;
+            layerEnd = states.size();
+        }
+        if(maxDepth >= 0 && depth >= maxDepth)
+            break;
+        //the discovered states are stored right away, so the budget stops like the maximum depth
+        if(budget && budget->exceeded(states.size()))
+            break;
+
+        s.id = next;
+        s.process = move(frontier.front());
+        frontier.pop_front();
+        expand(next, s, targets);
+        if(!visit(s, targets, discoveredId, observers, true))
+            return false;
+    }
+
+    for(size_t id = next; id < states.size(); id++)
+        for(CCSExplorer::Observer* o : observers)
+            o->unexplored(id, frontier[id - next]);
+    for(CCSExplorer::Observer* o : observers)
+        o->finished();
+    return true;
+}
+
+//ids and keys ((source id, index of the transition), the order of discovery) are split into two words in the records
+static void putId(uint32_t* r, uint64_t id)
+{
+    r[0] = id >> 32;
+    r[1] = (uint32_t)id;
+}
+
+static uint64_t getId(const uint32_t* r)
+{ return ((uint64_t)r[0] << 32) | r[1]; }
+
+bool CCSProductExplorer::exploreExternal(int maxDepth, const string& dir, const vector<CCSExplorer::Observer*>& observers,
+    size_t memory)
+{
+    CCSRef<CCSProcess> start = program.getProcess();
+    for(CCSExplorer::Observer* o : observers)
+        o->discovered(0, start, nullptr, 0);
+
+    //records: layer (vector), visited (vector, id), candidates (vector, key), fresh (key, vector),
+    //pending (key of the first discovery, key), resolved (key, id of the target)
+    size_t n = comps.size();
+    //the five sorters of a layer hold their memory at the same time (candidates keeps its blocks until the end of the layer),
+    //and the layers and the visited states are read and written through the buffers of four files
+    size_t files = 4 * CCSRecordFile::bufferSize;
+    size_t sortMemory = (memory > files ? memory - files : 0) / 5;
+    vector<uint32_t> r(n + 3), v(n + 3), w(n + 3), f(n + 3);
+    unique_ptr<CCSRecordFile> layer(new CCSRecordFile(dir, n));
+    unique_ptr<CCSRecordFile> visited(new CCSRecordFile(dir, n + 2));
+    //the initial local states are the first ones of their components
+    fill(v.begin(), v.end(), 0);
+    layer->write(v.data());
+    visited->write(v.data());
+
+    CCSExplorer::State s;
+    vector<uint32_t> targets;
+    size_t discoveredId = 1;
+    size_t layerId = 0;
+    size_t layerSize = 1;
+    for(int depth = 0; layerSize > 0 && (maxDepth < 0 || depth < maxDepth); depth++)
+    {
+        if(budget && budget->exceeded(discoveredId))
+            break;
+
+        //the targets of all transitions of the layer, sorted by their vectors
+        CCSExternalSorter candidates(dir, n + 3, sortMemory);
+        layer->rewind();
+        for(size_t i = 0; i < layerSize; i++)
+        {
+            layer->read(v.data());
+            s.process = nullptr;
+            successors(v.data(), s, targets);
+            for(size_t j = 0; j < s.trans.size(); j++)
+            {
+                copy_n(&targets[j * n], n, r.begin());
+                putId(&r[n], layerId + i);
+                r[n + 2] = j;
+                candidates.add(r.data());
+            }
+        }
+        candidates.sort();
+
+        //delayed duplicate detection: the targets are merged with the visited states, equal targets are adjacent,
+        //and the first of them is the first discovery
+        CCSExternalSorter fresh(dir, n + 3, sortMemory);
+        CCSExternalSorter pending(dir, 6, sortMemory);
+        CCSExternalSorter resolved(dir, 5, sortMemory);
+        visited->rewind();
+        bool hasVisited = visited->read(w.data());
+        bool known = false;
+        bool first = true;
+        uint32_t firstKey[3];
+        while(candidates.read(r.data()))
+        {
+            if(first || !equal(r.begin(), r.begin() + n, v.begin()))
+            {
+                first = false;
+                copy_n(r.begin(), n, v.begin());
+                while(hasVisited && lexicographical_compare(w.begin(), w.begin() + n, r.begin(), r.begin() + n))
+                    hasVisited = visited->read(w.data());
+                known = hasVisited && equal(r.begin(), r.begin() + n, w.begin());
+                copy_n(&r[n], 3, firstKey);
+                if(!known)
+                {
+                    copy_n(firstKey, 3, f.begin());
+                    copy_n(r.begin(), n, f.begin() + 3);
+                    fresh.add(f.data());
+                }
+            }
+            uint32_t e[6];
+            copy_n(&r[n], 3, e);
+            if(known)
+            {
+                copy_n(&w[n], 2, e + 3);
+                resolved.add(e);
+            }
+            else
+            {
+                copy_n(firstKey, 3, e + 3);
+                rotate(e, e + 3, e + 6);
+                pending.add(e);
+            }
+        }
+        fresh.sort();
+        pending.sort();
+
+        //the new states are numbered in the order of their first discovery, like in explore
+        unique_ptr<CCSRecordFile> next(new CCSRecordFile(dir, n));
+        CCSExternalSorter added(dir, n + 2, sortMemory);
+        size_t nextId = layerId + layerSize;
+        size_t nextSize = 0;
+        uint32_t p[6];
+        bool hasPending = pending.read(p);
+        while(fresh.read(r.data()))
+        {
+            size_t id = nextId + nextSize++;
+            next->write(&r[3]);
+            copy_n(&r[3], n, w.begin());
+            putId(&w[n], id);
+            added.add(w.data());
+            for(; hasPending && equal(p, p + 3, r.begin()); hasPending = pending.read(p))
+            {
+                uint32_t e[5];
+                copy_n(p + 3, 3, e);
+                putId(e + 3, id);
+                resolved.add(e);
+            }
+        }
+        resolved.sort();
+        added.sort();
+
+        //the new states are merged into the visited states
+        unique_ptr<CCSRecordFile> merged(new CCSRecordFile(dir, n + 2));
+        visited->rewind();
+        hasVisited = visited->read(w.data());
+        bool hasAdded = added.read(v.data());
+        while(hasVisited || hasAdded)
+        {
+            if(hasVisited && (!hasAdded || lexicographical_compare(w.begin(), w.begin() + n, v.begin(), v.begin() + n)))
+            {
+                merged->write(w.data());
+                hasVisited = visited->read(w.data());
+            }
+            else
+            {
+                merged->write(v.data());
+                hasAdded = added.read(v.data());
+            }
+        }
+        visited = move(merged);
+
+        //the transitions are computed again to notify the observers, with the ids of the targets in the order of the keys
+        layer->rewind();
+        for(size_t i = 0; i < layerSize; i++)
+        {
+            layer->read(v.data());
+            if(budget && budget->exceeded(discoveredId))
+            {
+                //the rest of the layer is unexplored, and of the next layer only the states discovered so far
+                for(size_t k = i; k < layerSize; k++)
+                {
+                    if(k > i)
+                        layer->read(v.data());
+                    CCSRef<CCSProcess> p = term(0, v.data());
+                    for(CCSExplorer::Observer* o : observers)
+                        o->unexplored(layerId + k, p);
+                }
+                next->rewind();
+                for(size_t id = nextId; id < discoveredId; id++)
+                {
+                    next->read(v.data());
+                    CCSRef<CCSProcess> p = term(0, v.data());
+                    for(CCSExplorer::Observer* o : observers)
+                        o->unexplored(id, p);
+                }
+                for(CCSExplorer::Observer* o : observers)
+                    o->finished();
+                return true;
+            }
+            s.id = layerId + i;
+            s.process = term(0, v.data());
+            successors(v.data(), s, targets);
+            for(size_t j = 0; j < s.trans.size(); j++)
+            {
+                uint32_t e[5];
+                resolved.read(e);
+                s.targets.push_back(getId(e + 3));
+            }
+            if(!visit(s, targets, discoveredId, observers, false))
+                return false;
+        }
+
+        layer = move(next);
+        layerId = nextId;
+        layerSize = nextSize;
+    }
+
+    layer->rewind();
+    for(size_t i = 0; i < layerSize; i++)
+    {
+        layer->read(v.data());
+        CCSRef<CCSProcess> p = term(0, v.data());
+        for(CCSExplorer::Observer* o : observers)
+            o->unexplored(layerId + i, p);
+    }
+    for(CCSExplorer::Observer* o : observers)
+        o->finished();
+    return true;
+}
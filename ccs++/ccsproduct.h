@@ -0,0 +1,239 @@
+#ifndef CCSPP_CCSPRODUCT_H_INCLUDED
+#define CCSPP_CCSPRODUCT_H_INCLUDED
+
+#include "ccs.h"
+#include "ccsexplorer.h"
+#include "ccshash.h"
+#include "ccssymmetry.h"
+#include "ccstree.h"
+
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ccspp
+{
+    /** @brief Breadth-first exploration of a network of sequential components.
+
+        If the main process is built from sequential processes (the components) by parallel composition and restriction,
+        the global states are vectors of local states of the components, and the terms of the global states
+        are not needed to compute the transitions. The transitions of every local state are computed once
+        and stored in the local LTS of its component. The transitions of a global state are combined from the
+        local transitions like CCSParallel and CCSRestrict do (synchronizing complementary actions, removing
+        restricted ones), and the visited table only stores the vectors of local state ids, compressed with CCSTreeTable.
+
+        The explored LTS, the ids of the states and the order of the transitions are the same as with CCSExplorer,
+        so the observers of CCSExplorer can be used. Normalized states are not supported: the normal form
+        of a global state sorts and removes components, so it is not a vector of local states. The terms of the states are built for the observers,
+        but the targets of the transitions in a State are nullptr (their ids are in targets).
+
+        A process is sequential if no parallel composition can be reached from it (also through process names),
+        so the network has a fixed number of components. The local LTS are built lazily,
+        components with infinitely many states (e.g. counters) are only explored as far as needed.
+    */
+    class CCSProductExplorer
+    {
+    public:
+        /** @brief The partial order reduction of the exploration (see setReduction). */
+        enum Reduction
+        {
+            NO_REDUCTION = 0,
+            PRESERVE_DEADLOCKS, /**< preserves the reachable deadlocks */
+            PRESERVE_ACTIONS    /**< also preserves the traces of visible (not internal) actions */
+        };
+
+    private:
+        struct LocalMove
+        {
+            CCSAction act;
+            uint32_t target;
+        };
+
+        struct Local
+        {
+            CCSRef<CCSProcess> process;
+            bool computed;
+            std::exception_ptr error;
+            std::vector<LocalMove> moves;
+        };
+
+        //the local LTS of a sequential component
+        struct Component
+        {
+            CCSHashMap<CCSRef<CCSProcess>, uint32_t, PtrHash<CCSProcess>, PtrEq<CCSProcess>> ids;
+            std::vector<Local> states;
+            bool visible;   //true if an action of the component may not be restricted
+        };
+
+        //a node of the network: a component, a parallel composition or a restriction
+        struct Node
+        {
+            CCSRef<CCSProcess> process;
+            std::vector<std::size_t> children;
+            std::size_t first;  //the components of the node are [first, last)
+            std::size_t last;
+        };
+
+        struct Change
+        {
+            std::size_t comp;
+            uint32_t local;
+        };
+
+        //a global transition: the components in changes[begin, end) change their local state
+        struct Move
+        {
+            CCSAction act;
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        //a symmetry of the network: a channel permutation and the permutation of the components it induces
+        struct Symmetry
+        {
+            CCSChannelPermutation perm;
+            std::vector<std::size_t> comps;
+            std::vector<std::vector<uint32_t>> images;  //the images of the local states, computed lazily
+        };
+
+        CCSProgram& program;
+        bool fold;
+        CCSBudget* budget;
+        Reduction reduction;
+        std::vector<std::vector<std::size_t>> users;    //the components using an action name, indexed by its id
+        bool symmetric;
+        std::vector<std::vector<std::size_t>> groups;   //the interchangeable components
+        std::vector<Symmetry> symmetries;
+        std::vector<Node> nodes;    //nodes[0] is the main process
+        std::vector<Component> comps;
+        CCSTreeTable states;    //the vectors of the local states of the global states
+        std::deque<CCSRef<CCSProcess>> frontier;    //the terms of the discovered, but unexplored states
+
+        std::vector<Move> moves;
+        std::vector<Change> changes;
+        std::vector<CCSTransition> scratch;
+        //the receives of a parallel node in collect, bucketed by channel and chained through recvNext (see CCSParallel)
+        std::vector<std::size_t> recvHeads;
+        std::vector<std::size_t> recvNext;
+        std::vector<uint64_t> recvKeys;
+
+        std::size_t build(const CCSRef<CCSProcess>& p);
+        uint32_t intern(std::size_t comp, const CCSRef<CCSProcess>& p);
+        const Local& local(std::size_t comp, uint32_t id);
+        void collect(std::size_t node, const uint32_t* state);
+        void apply(const Move& m, const uint32_t* state, uint32_t* out) const;
+        CCSRef<CCSProcess> term(std::size_t node, const uint32_t* state) const;
+        int compare(const uint32_t* s1, const uint32_t* s2) const;
+        void analyze(std::size_t node, std::vector<const CCSRestrict*>& restricts);
+        bool reduce(const uint32_t* state);
+        uint32_t image(Symmetry& sym, std::size_t comp, uint32_t id);
+        void sortGroups(uint32_t* state);
+        void canonicalize(uint32_t* state);
+        void vectorize(std::size_t node, const CCSRef<CCSProcess>& p, uint32_t* state);
+        bool successors(const uint32_t* state, CCSExplorer::State& s, std::vector<uint32_t>& out, bool reduced = false);
+        void expand(uint32_t id, CCSExplorer::State& s, std::vector<uint32_t>& targets);
+        bool visit(const CCSExplorer::State& s, const std::vector<uint32_t>& targets, std::size_t& discoveredId,
+            const std::vector<CCSExplorer::Observer*>& observers, bool keep);
+        CCSRef<CCSProcess> term(uint32_t id);
+
+    public:
+        /** @brief Constructs an explorer for the main process of a program, which must be a network (see isNetwork).
+            @param fold True if constant expression should be folded to constants.
+            @throws CCSException if the program normalizes its states (see CCSProgram::setNormalize).
+        */
+        CCSProductExplorer(CCSProgram& program, bool fold = true);
+
+        CCSProductExplorer(const CCSProductExplorer&) = delete;
+        CCSProductExplorer& operator= (const CCSProductExplorer&) = delete;
+
+        /** @brief Returns true if the main process of the program is a network of sequential components. */
+        static bool isNetwork(const CCSProgram& program);
+
+        /** @brief Returns the number of components. */
+        std::size_t getComponents() const;
+
+        /** @brief Sets the partial order reduction of explore (not exploreExternal).
+
+            A state only gets the transitions of a stubborn set of components: starting with a component
+            that has a transition, every component that may ever perform an action with the name of a current
+            action of a component in the set is added (computed from the names in the terms of the components).
+            The other components cannot enable or disable the transitions of the set, so their transitions
+            can be postponed, and every deadlock is still reached. The set with the fewest transitions is taken.
+            To preserve the traces of visible actions, a set with a visible transition also contains all components
+            that may perform visible actions, and a state is explored fully if a reduced transition leads to
+            a state that was already discovered (so no transition is postponed forever on a cycle).
+
+            The reduced LTS only contains some of the paths, so the paths to deadlocks may be longer,
+            and errors in states that are only reached by postponed transitions are not found.
+            A termination (delta) transition is never postponed.
+        */
+        void setReduction(Reduction reduction);
+
+        /** @brief Enables the symmetry reduction of the exploration.
+
+            Components that are children of the same parallel composition and start with the same process
+            are interchangeable, and every state is replaced by its representative, in which their local states
+            are sorted. The permutations of action names (by their ids) are symmetries given by the user,
+            e.g. the rotation (get1 get2 get3)(put1 put2 put3) of three dining philosophers. They must map
+            every component to one of its siblings whose process is the image of its process (matching
+            the process names like CCSChannelPermutation::match) and keep the restrictions. The representative
+            of a state is the smallest of the sorted images under the group generated by the permutations.
+
+            Only the representatives are explored, so the LTS is the quotient by the symmetries:
+            a deadlock is found as one of its symmetric deadlocks. A path of the quotient is not always a path of the LTS
+            (the components of a representative are in other positions, and with the permutations the names
+            of the actions after it differ), see lift to map it back. Not supported together with setReduction.
+            @throws CCSException if a permutation is not a symmetry of the network, renames a name that is not an action
+                of the program or the group is too large.
+        */
+        void setSymmetry(const std::vector<std::map<uint32_t, uint32_t>>& permutations = {});
+
+        /** @brief Returns a transition of the program from a state to a state whose representative
+            is the discovered state with the given id (see setSymmetry).
+
+            Every symmetry maps the transitions of a state to the transitions of its image, so a path of the quotient
+            is mapped back to a path of the program by following such transitions from the main process.
+            Can be called by the observers of explore (the transitions of the explored state are not changed).
+            @param from The main process or a target of a transition returned by lift.
+            @throws CCSException if there is no such transition.
+        */
+        CCSTransition lift(const CCSRef<CCSProcess>& from, std::size_t to);
+
+        /** @brief Sets the budget of the exploration like CCSExplorer::setBudget. */
+        void setBudget(CCSBudget* budget);
+
+        /** @brief Explores the LTS up to a depth and notifies the observers like CCSExplorer::explore.
+            Can only be called once.
+            @param maxDepth The number of layers to explore, or a negative number to explore all states.
+            @returns false if an observer stopped the exploration.
+        */
+        bool explore(int maxDepth, const std::vector<CCSExplorer::Observer*>& observers);
+
+        /** @brief Explores the LTS like explore, but keeps the visited states in files instead of memory
+            (external-memory BFS with delayed duplicate detection).
+
+            The vectors of the states of a layer are written to a file. The targets of all transitions of a layer
+            are sorted by their vectors (see CCSExternalSorter), and the duplicates among them are removed together
+            by merging them with the sorted file of all visited states, instead of looking up every target in a table.
+            The new states are numbered in the order of their discovery, so the ids and the observer calls
+            are the same as with explore. The memory used does not grow with the number of states,
+            except for the local LTS of the components.
+            Can only be called once.
+            @param dir The directory of the temporary files.
+            @param memory The size of the buffers of the sorters and the files in bytes (together).
+        */
+        bool exploreExternal(int maxDepth, const std::string& dir, const std::vector<CCSExplorer::Observer*>& observers,
+            std::size_t memory = (std::size_t)256 << 20);
+
+        /** @brief Returns the number of discovered states. */
+        std::size_t size() const;
+
+        /** @brief Returns the number of bytes used by the visited table. */
+        std::size_t getMemory() const;
+    };
+}
+
+#endif //CCSPP_CCSPRODUCT_H_INCLUDED
@@ -0,0 +1,30 @@
+#include "ccsref.h"
+#include "ccspool.h"
+
+using namespace std;
+using namespace ccspp;
+
+//the memory resource is stored in front of the term, the term itself stays aligned for any type
+static const size_t header = alignof(max_align_t);
+
+bool CCSRefCounted::atomicRefs = false;
+
+void* CCSRefCounted::operator new(size_t size)
+{
+    CCSMemoryResource* resource = CCSMemoryResource::get();
+    char* block = static_cast<char*>(resource->allocate(size + header));
+    *reinterpret_cast<CCSMemoryResource**>(block) = resource;
+    return block + header;
+}
+
+void CCSRefCounted::operator delete(void* p, size_t size)
+{
+    char* block = static_cast<char*>(p) - header;
+    (*reinterpret_cast<CCSMemoryResource**>(block))->deallocate(block, size + header);
+}
+
+bool CCSRefCounted::isAtomic()
+{ return atomicRefs; }
+
+void CCSRefCounted::setAtomic(bool atomic)
+{ atomicRefs = atomic; }
@@ -0,0 +1,252 @@
+#ifndef CCSPP_CCSREF_H_INCLUDED
+#define CCSPP_CCSREF_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace ccspp
+{
+    template<typename T>
+    class CCSRef;
+
+    template<typename T>
+    class CCSUniqueTable;
+
+    /** @brief Base class of reference-counted CCS terms (processes and expressions).
+
+        The reference count is stored in the term itself, so a term is a single allocation
+        without the control block, the weak count and the self reference of std::shared_ptr.
+        By default the count is updated with plain loads and stores.
+        setAtomic(true) switches to atomic read-modify-write operations,
+        which is required before terms are shared between threads.
+
+        Terms are allocated from the current CCSMemoryResource, which is stored in front of the term,
+        so a term is always freed by the resource that allocated it.
+    */
+    class CCSRefCounted
+    {
+        template<typename T>
+        friend class CCSRef;
+
+        template<typename T>
+        friend class CCSUniqueTable;
+
+    private:
+        mutable std::atomic<uint32_t> refs;
+
+        static bool atomicRefs;
+
+        void acquire() const
+        {
+            if(atomicRefs)
+                refs.fetch_add(1, std::memory_order_relaxed);
+            else
+                refs.store(refs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void release() const
+        {
+            uint32_t n;
+            if(atomicRefs)
+                n = refs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+            else
+            {
+                n = refs.load(std::memory_order_relaxed) - 1;
+                refs.store(n, std::memory_order_relaxed);
+            }
+            if(n == 0)
+                delete this;
+        }
+
+        //acquires a reference unless the term is already being destroyed (used by the weak entries of unique tables)
+        bool tryAcquire() const
+        {
+            uint32_t n = refs.load(std::memory_order_relaxed);
+            if(!atomicRefs)
+            {
+                if(n == 0)
+                    return false;
+                refs.store(n + 1, std::memory_order_relaxed);
+                return true;
+            }
+            do
+            {
+                if(n == 0)
+                    return false;
+            } while(!refs.compare_exchange_weak(n, n + 1, std::memory_order_relaxed));
+            return true;
+        }
+
+    protected:
+        /** @brief Constructor. The reference count starts at zero, the first CCSRef to the term owns it. */
+        CCSRefCounted()
+            :refs(0)
+        {}
+
+        CCSRefCounted(const CCSRefCounted&)
+            :refs(0)
+        {}
+
+        CCSRefCounted& operator= (const CCSRefCounted&)
+        { return *this; }
+
+        /** @brief Destructor. */
+        virtual ~CCSRefCounted() {}
+
+    public:
+        /** @brief Allocates a term from the current CCSMemoryResource. */
+        static void* operator new(std::size_t size);
+
+        /** @brief Frees a term (size is the size of its dynamic type). */
+        static void operator delete(void* p, std::size_t size);
+
+        /** @brief Returns true if reference counts are updated atomically. */
+        static bool isAtomic();
+
+        /** @brief Sets whether reference counts are updated atomically.
+            Must not be called while other threads use terms.
+        */
+        static void setAtomic(bool atomic);
+    };
+
+    /** @brief Reference to a reference-counted CCS term (see CCSRefCounted).
+        Used like std::shared_ptr, but a reference can also be created from a plain pointer to a term
+        that is owned by other references.
+    */
+    template<typename T>
+    class CCSRef
+    {
+        template<typename U>
+        friend class CCSRef;
+
+    private:
+        T* p;
+
+    public:
+        typedef T element_type;
+
+        /** @brief Constructs a null reference. */
+        CCSRef()
+            :p(nullptr)
+        {}
+
+        /** @brief Constructs a null reference. */
+        CCSRef(std::nullptr_t)
+            :p(nullptr)
+        {}
+
+        /** @brief Constructs a reference to p.
+            @param acquire False if the reference takes over a reference count already acquired for it.
+        */
+        explicit CCSRef(T* p, bool acquire = true)
+            :p(p)
+        {
+            if(p && acquire)
+                p->acquire();
+        }
+
+        CCSRef(const CCSRef& r)
+            :p(r.p)
+        {
+            if(p)
+                p->acquire();
+        }
+
+        CCSRef(CCSRef&& r) noexcept
+            :p(r.p)
+        { r.p = nullptr; }
+
+        template<typename U>
+        CCSRef(const CCSRef<U>& r)
+            :p(r.p)
+        {
+            if(p)
+                p->acquire();
+        }
+
+        template<typename U>
+        CCSRef(CCSRef<U>&& r) noexcept
+            :p(r.p)
+        { r.p = nullptr; }
+
+        ~CCSRef()
+        {
+            if(p)
+                p->release();
+        }
+
+        CCSRef& operator= (CCSRef r) noexcept
+        {
+            swap(r);
+            return *this;
+        }
+
+        /** @brief Returns the referenced term. */
+        T* get() const
+        { return p; }
+
+        T& operator* () const
+        { return *p; }
+
+        T* operator-> () const
+        { return p; }
+
+        explicit operator bool() const
+        { return p != nullptr; }
+
+        /** @brief Makes this a null reference without releasing the term.
+            \returns the term, whose reference count has to be taken over by another reference.
+        */
+        T* detach()
+        {
+            T* res = p;
+            p = nullptr;
+            return res;
+        }
+
+        /** @brief Makes this a null reference. */
+        void reset()
+        { CCSRef().swap(*this); }
+
+        void swap(CCSRef& r) noexcept
+        { std::swap(p, r.p); }
+    };
+
+    template<typename T, typename U>
+    bool operator== (const CCSRef<T>& r1, const CCSRef<U>& r2)
+    { return r1.get() == r2.get(); }
+
+    template<typename T, typename U>
+    bool operator!= (const CCSRef<T>& r1, const CCSRef<U>& r2)
+    { return r1.get() != r2.get(); }
+
+    template<typename T>
+    bool operator== (const CCSRef<T>& r, std::nullptr_t)
+    { return r.get() == nullptr; }
+
+    template<typename T>
+    bool operator== (std::nullptr_t, const CCSRef<T>& r)
+    { return r.get() == nullptr; }
+
+    template<typename T>
+    bool operator!= (const CCSRef<T>& r, std::nullptr_t)
+    { return r.get() != nullptr; }
+
+    template<typename T>
+    bool operator!= (std::nullptr_t, const CCSRef<T>& r)
+    { return r.get() != nullptr; }
+
+    /** @brief Casts a reference statically (like std::static_pointer_cast). */
+    template<typename T, typename U>
+    CCSRef<T> static_ref_cast(const CCSRef<U>& r)
+    { return CCSRef<T>(static_cast<T*>(r.get())); }
+
+    /** @brief Casts a reference statically, taking over its reference count. */
+    template<typename T, typename U>
+    CCSRef<T> static_ref_cast(CCSRef<U>&& r)
+    { return CCSRef<T>(static_cast<T*>(r.detach()), false); }
+}
+
+#endif //CCSPP_CCSREF_H_INCLUDED
@@ -0,0 +1,185 @@
+#include "ccssymmetry.h"
+
+using namespace std;
+using namespace ccspp;
+
+CCSChannelPermutation::CCSChannelPermutation(const CCSProgram& program, map<uint32_t, uint32_t> channels)
+    :bindings(program.getBindings()), channels(move(channels))
+{
+    //names mapped to themselves are dropped, so the identity is the empty map
+    for(auto it = this->channels.begin(); it != this->channels.end();)
+        if(it->first == it->second)
+            it = this->channels.erase(it);
+        else
+            ++it;
+}
+
+const map<uint32_t, uint32_t>& CCSChannelPermutation::getChannels() const
+{ return channels; }
+
+uint32_t CCSChannelPermutation::apply(uint32_t name) const
+{
+    auto it = channels.find(name);
+    return it == channels.end() ? name : it->second;
+}
+
+CCSAction CCSChannelPermutation::apply(const CCSAction& act) const
+{
+    uint32_t name = apply(act.getNameId());
+    if(name == act.getNameId())
+        return act;
+    else if(act.getInputId() != 0)
+        return CCSAction(act.getType(), CCSSymbols::name(name), act.getParam(), act.getInput());
+    else if(act.getExp() != nullptr)
+        return CCSAction(act.getType(), CCSSymbols::name(name), act.getParam(), act.getExp());
+    else
+        return CCSAction(act.getType(), CCSSymbols::name(name), act.getParam());
+}
+
+CCSRef<CCSProcess> CCSChannelPermutation::apply(const CCSRef<CCSProcess>& p) const
+{
+    switch(p->getType())
+    {
+    case CCSProcess::PROCESSNAME:
+    {
+        CCSProcessName* n = static_cast<CCSProcessName*>(p.get());
+        auto it = names.find(n->getNameId());
+        if(it == names.end())
+            return p;
+        return make_process<CCSProcessName>(it->second, n->getArgs());
+    }
+    case CCSProcess::PREFIX:
+    {
+        CCSPrefix* q = static_cast<CCSPrefix*>(p.get());
+        return make_process<CCSPrefix>(apply(q->getAction()), apply(q->getProcess()));
+    }
+    case CCSProcess::CHOICE:
+    {
+        CCSChoice* q = static_cast<CCSChoice*>(p.get());
+        return make_process<CCSChoice>(apply(q->getLeft()), apply(q->getRight()));
+    }
+    case CCSProcess::PARALLEL:
+    {
+        vector<CCSRef<CCSProcess>> ps;
+        for(const CCSRef<CCSProcess>& q : static_cast<CCSParallel*>(p.get())->getProcesses())
+            ps.push_back(apply(q));
+        return make_process<CCSParallel>(move(ps));
+    }
+    case CCSProcess::RESTRICT:
+    {
+        CCSRestrict* q = static_cast<CCSRestrict*>(p.get());
+        return make_process<CCSRestrict>(apply(q->getProcess()), *q);
+    }
+    case CCSProcess::SEQUENTIAL:
+    {
+        CCSSequential* q = static_cast<CCSSequential*>(p.get());
+        return make_process<CCSSequential>(apply(q->getLeft()), apply(q->getRight()));
+    }
+    case CCSProcess::WHEN:
+    {
+        CCSWhen* q = static_cast<CCSWhen*>(p.get());
+        return make_process<CCSWhen>(q->getCond(), apply(q->getProcess()));
+    }
+    default:
+        return p;
+    }
+}
+
+static bool equal(const CCSRef<CCSExp>& e1, const CCSRef<CCSExp>& e2)
+{ return e1 == e2 || (e1 != nullptr && e2 != nullptr && e1->compare(*e2) == 0); }
+
+bool CCSChannelPermutation::matches(const CCSRef<CCSProcess>& p, const CCSRef<CCSProcess>& q)
+{
+    if(p->getType() != q->getType())
+        return false;
+
+    switch(p->getType())
+    {
+    case CCSProcess::PROCESSNAME:
+    {
+        CCSProcessName* n1 = static_cast<CCSProcessName*>(p.get());
+        CCSProcessName* n2 = static_cast<CCSProcessName*>(q.get());
+        vector<CCSRef<CCSExp>> args1 = n1->getArgs();
+        vector<CCSRef<CCSExp>> args2 = n2->getArgs();
+        if(args1.size() != args2.size())
+            return false;
+        for(size_t i = 0; i < args1.size(); i++)
+            if(!equal(args1[i], args2[i]))
+                return false;
+
+        //a recursive name is assumed to match while its definition is compared
+        auto it = names.find(n1->getNameId());
+        if(it != names.end())
+            return it->second == n2->getNameId();
+        if(!images.insert(n2->getNameId()).second)
+            return false;
+        names[n1->getNameId()] = n2->getNameId();
+        auto b1 = bindings.find(n1->getName());
+        auto b2 = bindings.find(n2->getName());
+        if(b1 == bindings.end() || b2 == bindings.end())
+            return n1->getNameId() == n2->getNameId();
+        return b1->second.getParams() == b2->second.getParams() && matches(b1->second.getProcess(), b2->second.getProcess());
+    }
+    case CCSProcess::PREFIX:
+    {
+        CCSPrefix* q1 = static_cast<CCSPrefix*>(p.get());
+        CCSPrefix* q2 = static_cast<CCSPrefix*>(q.get());
+        return apply(q1->getAction()) == q2->getAction() && matches(q1->getProcess(), q2->getProcess());
+    }
+    case CCSProcess::CHOICE:
+    {
+        CCSChoice* q1 = static_cast<CCSChoice*>(p.get());
+        CCSChoice* q2 = static_cast<CCSChoice*>(q.get());
+        return matches(q1->getLeft(), q2->getLeft()) && matches(q1->getRight(), q2->getRight());
+    }
+    case CCSProcess::PARALLEL:
+    {
+        const vector<CCSRef<CCSProcess>>& ps1 = static_cast<CCSParallel*>(p.get())->getProcesses();
+        const vector<CCSRef<CCSProcess>>& ps2 = static_cast<CCSParallel*>(q.get())->getProcesses();
+        if(ps1.size() != ps2.size())
+            return false;
+        for(size_t i = 0; i < ps1.size(); i++)
+            if(!matches(ps1[i], ps2[i]))
+                return false;
+        return true;
+    }
+    case CCSProcess::RESTRICT:
+    {
+        //the restricted names are kept by apply, so they must not be renamed
+        CCSRestrict* q1 = static_cast<CCSRestrict*>(p.get());
+        CCSRestrict* q2 = static_cast<CCSRestrict*>(q.get());
+        if(q1->isComplement() != q2->isComplement() || q1->getR() != q2->getR())
+            return false;
+        for(const CCSAction& act : q1->getR())
+            if(apply(act.getNameId()) != act.getNameId())
+                return false;
+        return matches(q1->getProcess(), q2->getProcess());
+    }
+    case CCSProcess::SEQUENTIAL:
+    {
+        CCSSequential* q1 = static_cast<CCSSequential*>(p.get());
+        CCSSequential* q2 = static_cast<CCSSequential*>(q.get());
+        return matches(q1->getLeft(), q2->getLeft()) && matches(q1->getRight(), q2->getRight());
+    }
+    case CCSProcess::WHEN:
+    {
+        CCSWhen* q1 = static_cast<CCSWhen*>(p.get());
+        CCSWhen* q2 = static_cast<CCSWhen*>(q.get());
+        return equal(q1->getCond(), q2->getCond()) && matches(q1->getProcess(), q2->getProcess());
+    }
+    default:
+        return true;
+    }
+}
+
+bool CCSChannelPermutation::match(const CCSRef<CCSProcess>& p, const CCSRef<CCSProcess>& q)
+{
+    //the names matched by a failed attempt are forgotten
+    map<uint32_t, uint32_t> oldNames = names;
+    set<uint32_t> oldImages = images;
+    if(matches(p, q))
+        return true;
+    names = move(oldNames);
+    images = move(oldImages);
+    return false;
+}
@@ -0,0 +1,53 @@
+#ifndef CCSPP_CCSSYMMETRY_H_INCLUDED
+#define CCSPP_CCSSYMMETRY_H_INCLUDED
+
+#include "ccs.h"
+#include <map>
+#include <set>
+#include <string>
+
+namespace ccspp
+{
+    /** @brief A permutation of action names (channels) applied to processes.
+
+        A process is mapped to its image by renaming the names of its actions. Process names are renamed too:
+        match finds the process name whose definition is the image of a definition (e.g. Phil1 := get1!.get2!.Phil1
+        is mapped to Phil2 := get2!.get3!.Phil2 by (get1 get2 get3)), so the permutation can be applied to the
+        local states of sequential processes. Restrictions within the processes must not contain renamed names.
+    */
+    class CCSChannelPermutation
+    {
+    private:
+        std::map<std::string, CCSBinding> bindings;
+        std::map<uint32_t, uint32_t> channels;
+        std::map<uint32_t, uint32_t> names;     //the process names (ids) matched so far
+        std::set<uint32_t> images;
+
+        bool matches(const CCSRef<CCSProcess>& p, const CCSRef<CCSProcess>& q);
+
+    public:
+        /** @brief Constructs a permutation of the names of a program, mapping the names (ids) in channels
+            to their values and all other names to themselves.
+        */
+        CCSChannelPermutation(const CCSProgram& program, std::map<uint32_t, uint32_t> channels);
+
+        /** @brief Returns the mapping of the names that are not mapped to themselves. */
+        const std::map<uint32_t, uint32_t>& getChannels() const;
+
+        /** @brief Returns the image of an interned name. */
+        uint32_t apply(uint32_t name) const;
+
+        /** @brief Returns the image of an action. */
+        CCSAction apply(const CCSAction& act) const;
+
+        /** @brief Returns the image of a process (with the process names matched so far). */
+        CCSRef<CCSProcess> apply(const CCSRef<CCSProcess>& p) const;
+
+        /** @brief Returns true if q is the image of p, matching the process names in them
+            (the matches are kept if true is returned).
+        */
+        bool match(const CCSRef<CCSProcess>& p, const CCSRef<CCSProcess>& q);
+    };
+}
+
+#endif //CCSPP_CCSSYMMETRY_H_INCLUDED
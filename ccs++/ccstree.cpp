@@ -0,0 +1,142 @@
+#include "ccstree.h"
+#include "ccs.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace ccspp;
+
+static const size_t npos = -1;
+
+const uint32_t CCSTreeTable::empty;
+
+CCSTreeTable::CCSTreeTable(size_t width)
+    :width(max(width, (size_t)1)), hinted(false)
+{
+    build(0, this->width, true);
+    hint.resize(nodes.size());
+    hintValues.resize(this->width);
+}
+
+size_t CCSTreeTable::build(size_t first, size_t last, bool root)
+{
+    size_t node = nodes.size();
+    nodes.push_back(Node{ first, last, npos, npos, {}, {} });
+    //the root always has a table, so the ids of the vectors are the indices in it (even for vectors of width 1)
+    if(last - first <= 1 && !root)
+        return node;
+    size_t mid = first + (last - first + 1) / 2;
+    size_t left = build(first, mid, false);
+    size_t right = build(mid, last, false);
+    nodes[node].left = left;
+    nodes[node].right = right;
+    return node;
+}
+
+size_t CCSTreeTable::getWidth() const
+{ return width; }
+
+size_t CCSTreeTable::size() const
+{ return nodes[0].pairs.size(); }
+
+size_t CCSTreeTable::getMemory() const
+{
+    size_t res = 0;
+    for(const Node& n : nodes)
+        res += n.pairs.capacity() * sizeof(uint64_t) + n.slots.capacity() * sizeof(uint32_t);
+    return res;
+}
+
+size_t CCSTreeTable::hash(uint64_t pair)
+{ return hash_mix(pair); }
+
+pair<uint32_t, bool> CCSTreeTable::intern(Node& n, uint64_t pair)
+{
+    if((n.pairs.size() + 1) * 4 > n.slots.size() * 3)
+    {
+        //the slots only store indices, so the hashes are computed again from the pairs
+        n.slots.assign(n.slots.empty() ? 16 : n.slots.size() * 2, empty);
+        size_t mask = n.slots.size() - 1;
+        for(uint32_t k = 0; k < n.pairs.size(); k++)
+        {
+            size_t i = hash(n.pairs[k]) & mask;
+            while(n.slots[i] != empty)
+                i = (i + 1) & mask;
+            n.slots[i] = k + 1;
+        }
+    }
+
+    size_t mask = n.slots.size() - 1;
+    size_t i = hash(pair) & mask;
+    for(; n.slots[i] != empty; i = (i + 1) & mask)
+        if(n.pairs[n.slots[i] - 1] == pair)
+            return { n.slots[i] - 1, false };
+
+    if(n.pairs.size() >= (uint32_t)-2)
+        throw CCSException("too many states");
+    n.pairs.push_back(pair);
+    n.slots[i] = n.pairs.size();
+    return { n.pairs.size() - 1, true };
+}
+
+pair<uint32_t, bool> CCSTreeTable::insert(size_t node, const uint32_t* v)
+{
+    const Node& n = nodes[node];
+    if(n.left == npos)
+        return { n.first < n.last ? v[n.first] : 0, false };
+    if(hinted && memcmp(v + n.first, &hintValues[n.first], (n.last - n.first) * sizeof(uint32_t)) == 0)
+        return { hint[node], false };
+
+    uint64_t l = insert(n.left, v).first;
+    uint64_t r = insert(n.right, v).first;
+    return intern(nodes[node], (l << 32) | r);
+}
+
+pair<uint32_t, bool> CCSTreeTable::insert(const uint32_t* v)
+{ return insert(0, v); }
+
+pair<uint32_t, bool> CCSTreeTable::find(size_t node, const uint32_t* v) const
+{
+    const Node& n = nodes[node];
+    if(n.left == npos)
+        return { n.first < n.last ? v[n.first] : 0, true };
+
+    pair<uint32_t, bool> l = find(n.left, v);
+    if(!l.second || n.slots.empty())
+        return { 0, false };
+    pair<uint32_t, bool> r = find(n.right, v);
+    if(!r.second)
+        return { 0, false };
+
+    uint64_t key = ((uint64_t)l.first << 32) | r.first;
+    size_t mask = n.slots.size() - 1;
+    for(size_t i = hash(key) & mask; n.slots[i] != empty; i = (i + 1) & mask)
+        if(n.pairs[n.slots[i] - 1] == key)
+            return { n.slots[i] - 1, true };
+    return { 0, false };
+}
+
+pair<uint32_t, bool> CCSTreeTable::find(const uint32_t* v) const
+{ return find(0, v); }
+
+void CCSTreeTable::get(size_t node, uint32_t index, uint32_t* v)
+{
+    const Node& n = nodes[node];
+    if(n.left == npos)
+    {
+        if(n.first < n.last)
+            v[n.first] = index;
+        return;
+    }
+    hint[node] = index;
+    uint64_t pair = n.pairs[index];
+    get(n.left, pair >> 32, v);
+    get(n.right, (uint32_t)pair, v);
+}
+
+void CCSTreeTable::get(uint32_t id, uint32_t* v)
+{
+    get(0, id, v);
+    copy(v, v + width, hintValues.begin());
+    hinted = true;
+}
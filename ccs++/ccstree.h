@@ -0,0 +1,78 @@
+#ifndef CCSPP_CCSTREE_H_INCLUDED
+#define CCSPP_CCSTREE_H_INCLUDED
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ccspp
+{
+    /** @brief Set of fixed-size vectors of integers with tree compression.
+
+        A vector is split into two halves recursively, and every split is a node with its own table of pairs
+        (index of the left half, index of the right half); the halves of length 1 are the values themselves.
+        A vector is stored as one pair in the table of the root, and its halves are shared with all other vectors
+        having the same halves. The vectors of a state space usually differ in few positions,
+        so most of the pairs of a new vector are already in the tables, and a vector needs little more
+        than the 8 bytes of its root pair and a slot in the root table.
+
+        The vectors get consecutive ids in the order of their insertion (the indices in the root table).
+    */
+    class CCSTreeTable
+    {
+    private:
+        static const uint32_t empty = 0;    //slots store indices + 1
+
+        struct Node
+        {
+            std::size_t first;  //the positions [first, last) of the vectors
+            std::size_t last;
+            std::size_t left;   //child nodes, -1 if the node is a position
+            std::size_t right;
+            std::vector<uint64_t> pairs;
+            std::vector<uint32_t> slots;
+        };
+
+        std::size_t width;
+        std::vector<Node> nodes;    //nodes[0] is the root
+        std::vector<uint32_t> hint; //the indices of all nodes of the vector last returned by get
+        std::vector<uint32_t> hintValues;
+        bool hinted;
+
+        std::size_t build(std::size_t first, std::size_t last, bool root);
+        static std::size_t hash(uint64_t pair);
+        std::pair<uint32_t, bool> intern(Node& n, uint64_t pair);
+        std::pair<uint32_t, bool> insert(std::size_t node, const uint32_t* v);
+        std::pair<uint32_t, bool> find(std::size_t node, const uint32_t* v) const;
+        void get(std::size_t node, uint32_t index, uint32_t* v);
+
+    public:
+        /** @brief Constructs an empty table for vectors of width values (at least 1). */
+        CCSTreeTable(std::size_t width);
+
+        /** @brief Returns the number of values of the vectors. */
+        std::size_t getWidth() const;
+
+        /** @brief Inserts a vector of getWidth() values if it is not already contained.
+            The halves shared with the vector last returned by get are not looked up again.
+            @returns the id of the vector and true if it was inserted.
+        */
+        std::pair<uint32_t, bool> insert(const uint32_t* v);
+
+        /** @brief Looks up a vector of getWidth() values without inserting it.
+            @returns the id of the vector and true if it is contained.
+        */
+        std::pair<uint32_t, bool> find(const uint32_t* v) const;
+
+        /** @brief Writes the vector with the given id to v. */
+        void get(uint32_t id, uint32_t* v);
+
+        /** @brief Returns the number of vectors. */
+        std::size_t size() const;
+
+        /** @brief Returns the number of bytes used by the tables. */
+        std::size_t getMemory() const;
+    };
+}
+
+#endif //CCSPP_CCSTREE_H_INCLUDED
@@ -0,0 +1,111 @@
+#ifndef CCSPP_CCSUNIQUE_H_INCLUDED
+#define CCSPP_CCSUNIQUE_H_INCLUDED
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ccsref.h"
+
+namespace ccspp
+{
+    /** @brief Unique table for hash-consing of CCS terms.
+
+        The table maps the structural hash of a term to the canonical instance of that term.
+        Since all children of a term are already canonical, two terms are structurally equal
+        iff they have the same type, the same local data and pointer-equal children,
+        so looking up a term only costs a shallow comparison.
+
+        Entries are weak: a term is removed from the table by its destructor,
+        so the table never keeps a term alive.
+
+        The table is split into shards by the hash. While terms are shared between threads
+        (see CCSRefCounted::setAtomic), every shard is protected by its own lock,
+        so threads creating different terms rarely wait for each other.
+
+        T has to derive from CCSRefCounted and provide a `hash` member holding the structural hash,
+        an `interned` flag and a `compare(T&)` method.
+    */
+    template<typename T>
+    class CCSUniqueTable
+    {
+    private:
+        static const std::size_t shardBits = 6;
+
+        struct Shard
+        {
+            std::mutex lock;
+            std::unordered_multimap<uint64_t, T*> table;
+        };
+
+        Shard shards[1 << shardBits];
+
+        Shard& shard(uint64_t hash)
+        { return shards[hash >> (64 - shardBits)]; }
+
+    public:
+        /** @brief Returns the canonical instance of a term.
+            If there is no term equal to p in the table, p is inserted and returned.
+        */
+        CCSRef<T> intern(CCSRef<T> p)
+        {
+            //terms with the same hash that turn out to be different are released after unlocking,
+            //since releasing the last reference erases the term from the table
+            std::vector<CCSRef<T>> others;
+            Shard& s = shard(p->hash);
+            std::unique_lock<std::mutex> lock(s.lock, std::defer_lock);
+            if(CCSRefCounted::isAtomic())
+                lock.lock();
+
+            auto range = s.table.equal_range(p->hash);
+            for(auto it = range.first; it != range.second; ++it)
+            {
+                //a term is only compared while holding a reference, so it cannot be destroyed concurrently
+                if(!it->second->tryAcquire())
+                    continue;
+                CCSRef<T> other(it->second, false);
+                if(other->compare(*p) == 0)
+                    return other;
+                others.push_back(std::move(other));
+            }
+            p->interned = true;
+            s.table.emplace(p->hash, p.get());
+            return p;
+        }
+
+        /** @brief Removes a term from the table (called by the destructor of an interned term). */
+        void erase(T* p)
+        {
+            Shard& s = shard(p->hash);
+            std::unique_lock<std::mutex> lock(s.lock, std::defer_lock);
+            if(CCSRefCounted::isAtomic())
+                lock.lock();
+
+            auto range = s.table.equal_range(p->hash);
+            for(auto it = range.first; it != range.second; ++it)
+                if(it->second == p)
+                {
+                    s.table.erase(it);
+                    return;
+                }
+        }
+
+        /** @brief Returns the number of canonical terms. */
+        std::size_t size()
+        {
+            std::size_t res = 0;
+            for(Shard& s : shards)
+            {
+                std::unique_lock<std::mutex> lock(s.lock, std::defer_lock);
+                if(CCSRefCounted::isAtomic())
+                    lock.lock();
+                res += s.table.size();
+            }
+            return res;
+        }
+    };
+}
+
+#endif //CCSPP_CCSUNIQUE_H_INCLUDED
@@ -12,7 +12,7 @@ void CCSVisitor<void>::visit(CCSProcess& p)
 void CCSVisitor<void>::visit(CCSProcess* p)
 { p->accept(this); }
 
-void CCSVisitor<void>::visit(shared_ptr<CCSProcess> p)
+void CCSVisitor<void>::visit(CCSRef<CCSProcess> p)
 { p->accept(this); }
 
 void CCSExpVisitor<void>::visit(CCSExp& p)
@@ -21,5 +21,5 @@ void CCSExpVisitor<void>::visit(CCSExp& p)
 void CCSExpVisitor<void>::visit(CCSExp* p)
 { p->accept(this); }
 
-void CCSExpVisitor<void>::visit(shared_ptr<CCSExp> p)
+void CCSExpVisitor<void>::visit(CCSRef<CCSExp> p)
 { p->accept(this); }
@@ -21,7 +21,7 @@ namespace ccspp
 
         void visit(CCSProcess& p);
         void visit(CCSProcess* p);
-        void visit(std::shared_ptr<CCSProcess> p);
+        void visit(CCSRef<CCSProcess> p);
     };
 
     template<typename V>
@@ -74,7 +74,7 @@ namespace ccspp
         void vvisit(CCSProcess* p, V v)
         { this->v = &v; p->accept(this); }
 
-        void vvisit(std::shared_ptr<CCSProcess> p, V v)
+        void vvisit(CCSRef<CCSProcess> p, V v)
         { this->v = &v; p->accept(this); }
     };
 
@@ -128,7 +128,7 @@ namespace ccspp
         T vvisit(CCSProcess* p)
         { p->accept(this); return ret; }
 
-        T vvisit(std::shared_ptr<CCSProcess> p)
+        T vvisit(CCSRef<CCSProcess> p)
         { p->accept(this); return ret; }
     };
 
@@ -183,7 +183,7 @@ namespace ccspp
         T vvisit(CCSProcess* p, V v)
         { this->v = &v; p->accept(this); return ret; }
 
-        T vvisit(std::shared_ptr<CCSProcess> p, V v)
+        T vvisit(CCSRef<CCSProcess> p, V v)
         { this->v = &v; p->accept(this); return ret; }
     };
 
@@ -198,7 +198,7 @@ namespace ccspp
 
         void visit(CCSExp& e);
         void visit(CCSExp* e);
-        void visit(std::shared_ptr<CCSExp> e);
+        void visit(CCSRef<CCSExp> e);
     };
 
     template<typename V>
@@ -231,7 +231,7 @@ namespace ccspp
         void vvisit(CCSExp* e, V v)
         { this->v = &v; e->accept(this); }
 
-        void vvisit(std::shared_ptr<CCSExp> e, V v)
+        void vvisit(CCSRef<CCSExp> e, V v)
         { this->v = &v; e->accept(this); }
     };
 
@@ -265,7 +265,7 @@ namespace ccspp
         T vvisit(CCSExp* e)
         { e->accept(this); return ret; }
 
-        T vvisit(std::shared_ptr<CCSExp> e)
+        T vvisit(CCSRef<CCSExp> e)
         { e->accept(this); return ret; }
     };
 
@@ -300,7 +300,7 @@ namespace ccspp
         T vvisit(CCSExp* e, V v)
         { this->v = &v; e->accept(this); return ret; }
 
-        T vvisit(std::shared_ptr<CCSExp> e, V v)
+        T vvisit(CCSRef<CCSExp> e, V v)
         { this->v = &v; e->accept(this); return ret; }
     };
 }
@@ -1,5 +1,5 @@
 #include "main.h"
-#include "cmd_graph.h"
+#include "cmd_actions.h"
 
 #include <iostream>
 #include <memory>
@@ -7,54 +7,13 @@
 using namespace std;
 using namespace ccspp;
 
-int cmd_actions(CCSProgram& program)
-{
-    set<CCSAction> actions;
-    set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>> visited;
-    set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>> frontier;
-    
-    frontier.insert(program.getProcess());
-
-    int depth = 0;
-    while((opt_max_depth < 0 || depth < opt_max_depth) && !frontier.empty())
-    {
-        set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>> frontier2;
-        for(shared_ptr<CCSProcess> p : frontier)
-        {
-            visited.insert(p);
-
-            set<CCSTransition> trans;
-            try
-            {
-                trans = p->getTransitions(program, !opt_no_fold);
-            }
-            catch(CCSException& ex)
-            {
-                if(opt_ignore_error)
-                    cerr << "warning: " << ex.what() << endl;
-                else
-                {
-                    cerr << "error: " << ex.what() << endl;
-                    return 1;
-                }
-            }
+ActionsAnalysis::ActionsAnalysis(ostream& out)
+    :out(out)
+{}
 
-            for(CCSTransition t : trans)
-            {
-                CCSAction act = t.getAction();
-                if(!actions.count(act))
-                {
-                    cout << act << endl;
-                    actions.insert(act);
-                }
-                shared_ptr<CCSProcess> p2 = t.getTo();
-                if(!visited.count(p2))
-                    frontier2.insert(p2);
-            }
-        }
-
-        depth++;
-        frontier = move(frontier2);
-    }
-    return 0;
+void ActionsAnalysis::transition(const CCSExplorer::State& s, size_t i)
+{
+    const CCSAction& act = s.trans[i].getAction();
+    if(actions.insert(act))
+        out << act << endl;
 }
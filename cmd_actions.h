@@ -2,7 +2,22 @@
 #define CMD_ACTIONS_H_INCLUDED
 
 #include "ccs++/ccs.h"
+#include "ccs++/ccsexplorer.h"
 
-int cmd_actions(ccspp::CCSProgram& program);
+#include <functional>
+#include <iostream>
+
+/** @brief Analysis printing every action of the LTS once. */
+class ActionsAnalysis : public ccspp::CCSExplorer::Observer
+{
+private:
+    std::ostream& out;
+    ccspp::CCSHashSet<ccspp::CCSAction, std::hash<ccspp::CCSAction>, std::equal_to<ccspp::CCSAction>> actions;
+
+public:
+    ActionsAnalysis(std::ostream& out);
+
+    virtual void transition(const ccspp::CCSExplorer::State& s, std::size_t i);
+};
 
 #endif //CMD_ACTIONS_H_INCLUDED
@@ -1,99 +1,204 @@
 #include "main.h"
 #include "cmd_dead.h"
+#include "cmd_explore.h"
 
+#include "ccs++/ccsbitstate.h"
+#include "ccs++/ccsdfs.h"
+
+#include <algorithm>
 #include <iostream>
 #include <memory>
-#include <stack>
+#include <mutex>
+#include <string>
 
 using namespace std;
 using namespace ccspp;
 
-int cmd_dead(CCSProgram& program)
+DeadAnalysis::DeadAnalysis(ostream& out, CCSProgram* program, const string& dir)
+    :out(out), program(program), dir(dir), symmetric(nullptr)
+{}
+
+void DeadAnalysis::setSymmetric(CCSProductExplorer* explorer)
+{ symmetric = explorer; }
+
+void DeadAnalysis::discovered(size_t id, const CCSRef<CCSProcess>& p, const CCSExplorer::State* from, size_t i)
 {
-    set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>> visited;
-    set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>> frontier;
-    map<shared_ptr<CCSProcess>, CCSTransition, PtrCmp<CCSProcess>> pred;
-    
-    frontier.insert(program.getProcess());
+    if(program && !dir.empty())
+    {
+        //the records are (id of the source (two words), index of the transition), the id of a state is the index of its record;
+        //the file is created with the initial state, so errors are reported by the exploration
+        if(!records)
+            records.reset(new CCSRecordFile(dir, 3));
+        uint64_t source = from ? from->id : 0;
+        uint32_t r[3] = { (uint32_t)(source >> 32), (uint32_t)source, (uint32_t)(from ? i : 0) };
+        records->write(r);
+        return;
+    }
+    predId.push_back(from ? from->id : 0);
+    if(!from)
+        start = p;
+    if(program)
+        predIndex.push_back(from ? i : 0);
+    else if(!symmetric)
+        //the targets of the transitions are not always built (see CCSProductExplorer), so the transition is made from the states
+        pred.push_back(from ? CCSTransition(from->trans[i].getAction(), from->process, p) : CCSTransition());
+}
 
-    int depth = 0;
-    while((opt_max_depth < 0 || depth < opt_max_depth) && !frontier.empty())
+void DeadAnalysis::deadlock(const CCSExplorer::State& s)
+{
+    vector<CCSTransition> path;
+    CCSRef<CCSProcess> last = s.process;
+    if(program)
     {
-        set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>> frontier2;
-        for(shared_ptr<CCSProcess> p : frontier)
+        //the transitions of a state are always computed in the same order, so the indices lead to the deadlock again
+        vector<uint32_t> indices;
+        if(records)
         {
-            visited.insert(p);
-
-            set<CCSTransition> trans;
-            try
+            //the sources have smaller ids, so the path is read backwards through the file
+            uint32_t r[3];
+            for(size_t id = s.id; id != 0; id = ((uint64_t)r[0] << 32) | r[1])
             {
-                trans = p->getTransitions(program, !opt_no_fold);
+                records->read(id, r);
+                indices.push_back(r[2]);
             }
-            catch(CCSException& ex)
+        }
+        else
+            for(size_t id = s.id; id != 0; id = predId[id])
+                indices.push_back(predIndex[id]);
+        CCSRef<CCSProcess> p = program->getProcess();
+        vector<CCSTransition> trans;
+        try
+        {
+            for(auto it = indices.rbegin(); it != indices.rend(); ++it)
             {
-                if(opt_ignore_error)
-                {
-                    cerr << "warning: " << ex.what() << endl;
-                    continue;
-                }
-                else
-                {
-                    cerr << "error: " << ex.what() << endl;
-                    return 1;
-                }
+                p->getTransitions(*program, trans, !opt_no_fold);
+                if(*it >= trans.size())
+                    throw CCSException("the path to a deadlock cannot be rebuilt: transition " + to_string(*it)
+                        + " of a state with " + to_string(trans.size()) + " transitions");
+                path.push_back(trans[*it]);
+                p = trans[*it].getTo();
             }
-
-            if(trans.empty())
+        }
+        catch(CCSException& ex)
+        {
+            cerr << "error: " << ex.what() << endl;
+            return;
+        }
+    }
+    else if(symmetric)
+    {
+        //the states of the program on the path are symmetric to the representatives, so the path ends in a deadlock too
+        vector<size_t> ids;
+        for(size_t id = s.id; id != 0; id = predId[id])
+            ids.push_back(id);
+        last = start;
+        try
+        {
+            for(auto it = ids.rbegin(); it != ids.rend(); ++it)
             {
-                stack<CCSTransition> path;
-                while(pred.count(p))
-                {
-                    CCSTransition next = pred[p];
-                    path.push(next);
-                    p = next.getFrom();
-                }
-
-                if(opt_full_paths)
-                {
-                    cout << *path.top().getFrom();
-                    while(!path.empty())
-                    {
-                        CCSTransition next = path.top();
-                        path.pop();
-                        cout << "   --( " << next.getAction() << " )->   " << *next.getTo();
-                    }
-                    cout << endl;
-                }
-                else
-                {
-                    cout << "[";
-                    bool first = true;
-                    while(!path.empty())
-                    {
-                        if(!first)
-                            cout << ", ";
-                        first = false;
-                        cout << path.top().getAction();
-                        p = path.top().getTo();
-                        path.pop();
-                    }
-                    cout << "] ~> " << *p << endl;
-                }
+                path.push_back(symmetric->lift(last, *it));
+                last = path.back().getTo();
             }
+        }
+        catch(CCSException& ex)
+        {
+            cerr << "error: " << ex.what() << endl;
+            return;
+        }
+    }
+    else
+    {
+        for(size_t id = s.id; id != 0; id = predId[id])
+            path.push_back(pred[id]);
+        reverse(path.begin(), path.end());
+    }
+    printDeadlock(out, path, last);
+}
 
-            for(CCSTransition t : trans)
-            {
-                shared_ptr<CCSProcess> p2 = t.getTo();
-                if(!visited.count(p2))
-                {
-                    frontier2.insert(p2);
-                    pred[p2] = t;
-                }
-            }
+void printDeadlock(ostream& out, const vector<CCSTransition>& path, const CCSRef<CCSProcess>& last)
+{
+    if(opt_full_paths)
+    {
+        out << *(path.empty() ? last : path.front().getFrom());
+        for(const CCSTransition& t : path)
+            out << "   --( " << t.getAction() << " )->   " << *t.getTo();
+        out << endl;
+    }
+    else
+    {
+        out << "[";
+        bool first = true;
+        for(const CCSTransition& t : path)
+        {
+            if(!first)
+                out << ", ";
+            first = false;
+            out << t.getAction();
         }
+        out << "] ~> " << *last << endl;
+    }
+}
+
+//depth-first search for deadlocks in bit-state mode, the deadlocks are printed when they are found
+class BitStateDeadVisitor : public CCSDepthFirstExplorer::Visitor
+{
+private:
+    mutex lock;
+    CCSBitState& table;
+    CCSBudget& budget;
 
-        depth++;
-        frontier = move(frontier2);
+public:
+    BitStateDeadVisitor(CCSBitState& table, CCSBudget& budget)
+        :table(table), budget(budget)
+    {}
+
+    //once the budget is exceeded, the remaining paths on the stacks are dropped
+    virtual bool enter(const CCSDepthFirstExplorer::Path& path, unsigned worker)
+    { return (opt_max_depth < 0 || (int)path.getLength() < opt_max_depth) && !budget.exceeded(table.getStored()); }
+
+    virtual bool expand(const CCSDepthFirstExplorer::Path& path, const vector<CCSTransition>& trans, unsigned worker)
+    {
+        if(trans.empty())
+        {
+            vector<CCSTransition> trace = path.getTrace();
+            lock_guard<mutex> l(lock);
+            printDeadlock(cout, trace, path.getProcess());
+        }
+        return true;
+    }
+
+    virtual void error(const CCSDepthFirstExplorer::Path& path, const CCSException& ex, unsigned worker)
+    {
+        if(!opt_ignore_error)
+            throw;
+        lock_guard<mutex> l(lock);
+        cerr << "warning: " << ex.what() << endl;
+    }
+};
+
+int cmd_dead_bitstate(CCSProgram& program)
+{
+    CCSBitState table(opt_bitstate);
+    CCSDepthFirstExplorer explorer(program, !opt_no_fold, opt_threads, true);
+    explorer.setBitState(&table);
+    CCSBudget budget(opt_max_states, (size_t)opt_max_memory << 20, opt_timeout);
+    BitStateDeadVisitor visitor(table, budget);
+    int res = 0;
+    try
+    {
+        explorer.explore(visitor);
     }
-    return 0;
+    catch(CCSException& ex)
+    {
+        cerr << "error: " << ex.what() << endl;
+        res = 1;
+    }
+
+    cerr << "bitstate: " << table.getStored() << " states stored in 2^" << opt_bitstate << " bits with "
+        << table.getHashes() << " bits per state (" << 100 * table.getFill() << "% of the bits set)" << endl;
+    cerr << "bitstate: estimated coverage " << 100 * table.getCoverage() << "%, omission probability per state "
+        << table.getOmissionProbability() << endl;
+    if(res == 0 && report_budget(budget, table.getStored()))
+        res = 2;
+    return res;
 }
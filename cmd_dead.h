@@ -2,7 +2,57 @@
 #define CMD_DEAD_H_INCLUDED
 
 #include "ccs++/ccs.h"
+#include "ccs++/ccsexplorer.h"
+#include "ccs++/ccsexternal.h"
+#include "ccs++/ccsproduct.h"
 
-int cmd_dead(ccspp::CCSProgram& program);
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** @brief Analysis printing a shortest path to every deadlock (state without transitions).
+
+    If a program is given, the transitions to the states are not kept, but only the index of the transition
+    every state was discovered with. The path to a deadlock is then rebuilt by computing the transitions
+    along the path again, starting at the main process of the program. If also a directory is given,
+    the id of the source and the index of the transition of every state are written to a file in it
+    instead of memory (see CCSProductExplorer::exploreExternal), and the path is read back from the deadlock.
+    With the symmetry reduction, the path through the representatives is mapped back with CCSProductExplorer::lift,
+    so the printed path and its states are a path of the program.
+*/
+class DeadAnalysis : public ccspp::CCSExplorer::Observer
+{
+private:
+    std::ostream& out;
+    ccspp::CCSProgram* program;
+    //the transition every state was discovered with and the id of its source, indexed by the id of the state
+    std::vector<ccspp::CCSTransition> pred;
+    std::vector<std::size_t> predId;
+    std::vector<uint32_t> predIndex;    //used instead of pred if the paths are rebuilt
+    std::string dir;
+    std::unique_ptr<ccspp::CCSRecordFile> records;  //used instead of predId and predIndex with a directory
+    ccspp::CCSProductExplorer* symmetric;   //the explorer mapping the paths back, if it uses the symmetry reduction
+    ccspp::CCSRef<ccspp::CCSProcess> start;
+
+public:
+    DeadAnalysis(std::ostream& out, ccspp::CCSProgram* program = nullptr, const std::string& dir = "");
+
+    /** @brief Maps the paths back to paths of the program with an explorer using the symmetry reduction
+        (only the ids of the predecessors are kept then).
+    */
+    void setSymmetric(ccspp::CCSProductExplorer* explorer);
+
+    virtual void discovered(std::size_t id, const ccspp::CCSRef<ccspp::CCSProcess>& p, const ccspp::CCSExplorer::State* from, std::size_t i);
+    virtual void deadlock(const ccspp::CCSExplorer::State& s);
+};
+
+/** @brief Prints a path to a deadlock (as a trace, or with all states if opt_full_paths is set). */
+void printDeadlock(std::ostream& out, const std::vector<ccspp::CCSTransition>& path, const ccspp::CCSRef<ccspp::CCSProcess>& last);
+
+/** @brief Searches for deadlocks depth-first, storing the visited states in a bit-state table of 2^opt_bitstate bits.
+    The search is fast and needs a fixed amount of memory, but may miss states. The estimated coverage is printed at the end.
+*/
+int cmd_dead_bitstate(ccspp::CCSProgram& program);
 
 #endif //CMD_DEAD_H_INCLUDED
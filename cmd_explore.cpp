@@ -0,0 +1,194 @@
+#include "main.h"
+#include "cmd_explore.h"
+#include "cmd_graph.h"
+#include "cmd_actions.h"
+#include "cmd_dead.h"
+#include "cmd_minimize.h"
+#include "ccs++/ccsproduct.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+using namespace std;
+using namespace ccspp;
+
+//reports errors during the exploration once for all analyses, and stops the exploration unless errors are ignored
+class ErrorReporter : public CCSExplorer::Observer
+{
+public:
+    virtual bool error(const CCSExplorer::State& s)
+    {
+        if(opt_ignore_error)
+        {
+            cerr << "warning: " << s.message << endl;
+            return true;
+        }
+        cerr << "error: " << s.message << endl;
+        return false;
+    }
+};
+
+//counts the discovered states for the summary of the budget
+class StateCounter : public CCSExplorer::Observer
+{
+public:
+    size_t states = 0;
+
+    virtual void discovered(size_t id, const CCSRef<CCSProcess>& p, const CCSExplorer::State* from, size_t i)
+    { states++; }
+};
+
+//the reason why the reductions of the product explorer cannot be used, or an empty string
+static string reductionError(CCSProgram& program)
+{
+    if(opt_no_product)
+        return "not supported with --no-product";
+    else if(!opt_external.empty())
+        return "not supported with --external";
+    else if(opt_normalize)
+        return "not supported with --normalize";
+    else if(!CCSProductExplorer::isNetwork(program))
+        return "only supported for networks of sequential processes";
+    return "";
+}
+
+bool is_analysis(const string& name)
+{ return name == "graph" || name == "actions" || name == "dead" || name == "minimize"; }
+
+int cmd_explore(CCSProgram& program, const vector<string>& analyses)
+{
+    ErrorReporter reporter;
+    StateCounter counter;
+    vector<unique_ptr<ostringstream>> buffers;
+    vector<unique_ptr<CCSExplorer::Observer>> owned;
+    vector<CCSExplorer::Observer*> observers{ &reporter, &counter };
+    vector<DeadAnalysis*> deads;
+    for(const string& name : analyses)
+    {
+        ostream* out = &cout;
+        if(!owned.empty())
+        {
+            buffers.emplace_back(new ostringstream());
+            out = buffers.back().get();
+        }
+
+        if(name == "graph")
+            owned.emplace_back(new GraphAnalysis(*out));
+        else if(name == "actions")
+            owned.emplace_back(new ActionsAnalysis(*out));
+        else if(name == "minimize")
+            owned.emplace_back(new MinimizeAnalysis(*out));
+        else
+        {
+            //the paths are rebuilt from the indices of the transitions, which differ in a reduced LTS;
+            //with normalized states, the transitions are kept, so the paths do not depend on the order of the normal forms
+            bool replay = !opt_external.empty() || (opt_hash_compaction && !opt_por && !opt_symmetry && !opt_normalize);
+            deads.push_back(new DeadAnalysis(*out, replay ? &program : nullptr, opt_external));
+            owned.emplace_back(deads.back());
+        }
+        observers.push_back(owned.back().get());
+    }
+
+    //networks of sequential processes are explored as the product of their components, unless several threads are used
+    //or the states are normalized (the normal form of a global state is not a vector of local states)
+    CCSBudget budget(opt_max_states, (size_t)opt_max_memory << 20, opt_timeout);
+    bool completed;
+    string unsupported = opt_por || opt_symmetry ? reductionError(program) : "";
+    if(opt_por && !unsupported.empty())
+    {
+        cerr << "error: the partial order reduction is " << unsupported << endl;
+        return 1;
+    }
+    if(opt_symmetry && opt_por)
+    {
+        cerr << "error: the symmetry reduction is not supported with --por" << endl;
+        return 1;
+    }
+    if(opt_symmetry && !unsupported.empty())
+    {
+        cerr << "error: the symmetry reduction is " << unsupported << endl;
+        return 1;
+    }
+    //the reductions explore an LTS that is not bisimilar to the full one (the symmetry reduction only renames actions)
+    if(find(analyses.begin(), analyses.end(), "minimize") != analyses.end() && (opt_por || !opt_permutations.empty() || !opt_external.empty()))
+    {
+        cerr << "error: minimize is not supported with --por, --permutation or --external" << endl;
+        return 1;
+    }
+    if(!opt_external.empty())
+    {
+        if(opt_no_product || !CCSProductExplorer::isNetwork(program))
+        {
+            cerr << "error: the external mode is only supported for networks of sequential processes" << endl;
+            return 1;
+        }
+        if(opt_normalize)
+        {
+            cerr << "error: the external mode is not supported with --normalize" << endl;
+            return 1;
+        }
+        CCSProductExplorer explorer(program, !opt_no_fold);
+        explorer.setBudget(&budget);
+        //the other half of the memory limit is left for the components and the rest of the process
+        size_t memory = (size_t)256 << 20;
+        if(opt_max_memory > 0)
+            memory = min(memory, ((size_t)opt_max_memory << 20) / 2);
+        try
+        {
+            completed = explorer.exploreExternal(opt_max_depth, opt_external, observers, memory);
+        }
+        catch(CCSException& ex)
+        {
+            cerr << "error: " << ex.what() << endl;
+            completed = false;
+        }
+    }
+    else if(opt_por || opt_symmetry || (!opt_no_product && !opt_normalize && opt_threads == 1 && CCSProductExplorer::isNetwork(program)))
+    {
+        CCSProductExplorer explorer(program, !opt_no_fold);
+        explorer.setBudget(&budget);
+        //the traces of the actions are only needed by actions
+        if(opt_por)
+            explorer.setReduction(find(analyses.begin(), analyses.end(), "actions") != analyses.end() ?
+                CCSProductExplorer::PRESERVE_ACTIONS : CCSProductExplorer::PRESERVE_DEADLOCKS);
+        if(opt_symmetry)
+        {
+            try
+            {
+                explorer.setSymmetry(opt_permutations);
+            }
+            catch(CCSException& ex)
+            {
+                cerr << "error: " << ex.what() << endl;
+                return 1;
+            }
+            for(DeadAnalysis* dead : deads)
+                dead->setSymmetric(&explorer);
+        }
+        completed = explorer.explore(opt_max_depth, observers);
+    }
+    else
+    {
+        CCSExplorer explorer(program, !opt_no_fold, opt_threads, opt_hash_compaction);
+        explorer.setBudget(&budget);
+        completed = explorer.explore(opt_max_depth, observers);
+    }
+    for(unique_ptr<ostringstream>& buffer : buffers)
+        cout << buffer->str();
+    if(!completed)
+        return 1;
+    //the results are incomplete, but valid for the explored part of the LTS
+    return report_budget(budget, counter.states) ? 2 : 0;
+}
+
+bool report_budget(const CCSBudget& budget, size_t states)
+{
+    static const char* limits[] = { "", "state", "memory", "time" };
+    if(budget.getExceeded() == CCSBudget::NONE)
+        return false;
+    cerr << "budget: stopped at the " << limits[budget.getExceeded()] << " limit after " << budget.getElapsed() << " s, "
+        << states << " states discovered, " << (CCSBudget::getPeakMemory() >> 20) << " MB peak memory" << endl;
+    return true;
+}
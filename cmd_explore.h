@@ -0,0 +1,25 @@
+#ifndef CMD_EXPLORE_H_INCLUDED
+#define CMD_EXPLORE_H_INCLUDED
+
+#include "ccs++/ccs.h"
+#include "ccs++/ccsbudget.h"
+
+#include <string>
+#include <vector>
+
+/** @brief Returns true if the command is an analysis that can be run by cmd_explore (graph, actions, dead or minimize). */
+bool is_analysis(const std::string& name);
+
+/** @brief Explores the LTS once (breadth-first) and runs all analyses on it.
+    The output of the first analysis is written directly to standard output,
+    the output of the others is collected and written after the exploration, in the given order.
+*/
+int cmd_explore(ccspp::CCSProgram& program, const std::vector<std::string>& analyses);
+
+/** @brief Prints a summary to standard error if a limit of the budget stopped the exploration.
+    @param states The number of discovered states.
+    @returns true if a limit was exceeded.
+*/
+bool report_budget(const ccspp::CCSBudget& budget, std::size_t states);
+
+#endif //CMD_EXPLORE_H_INCLUDED
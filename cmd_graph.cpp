@@ -8,85 +8,53 @@
 using namespace std;
 using namespace ccspp;
 
-void printNode(int id, CCSProcess& p, bool error, bool explored, bool term)
+GraphAnalysis::GraphAnalysis(ostream& out)
+    :out(out)
+{}
+
+void GraphAnalysis::printNode(size_t id, CCSProcess& p, bool error, bool explored, bool term)
 {
-    cout << "    p" << id << " [";
+    out << "    p" << id << " [";
     if(opt_omit_names)
-        cout << "label=\"\"";
+        out << "label=\"\"";
     else
-        cout << "label=" << quoted((string)p);
+        out << "label=" << quoted((string)p);
     if(term)
-        cout << ",shape=box";
+        out << ",shape=box";
     if(!explored)
-        cout << ",style=dashed";
+        out << ",style=dashed";
     if(error)
-        cout << ",color=red";
-    cout << "];" << endl;
+        out << ",color=red";
+    out << "];" << endl;
 }
 
-int cmd_graph(CCSProgram& program)
+void GraphAnalysis::discovered(size_t id, const CCSRef<CCSProcess>& p, const CCSExplorer::State* from, size_t i)
 {
-    cout << "digraph lts {" << endl;
+    //the discovery of the initial state starts the graph
+    if(from)
+        return;
+    out << "digraph lts {" << endl;
+    out << "    start [shape=point];" << endl;
+    out << "    start -> p0;" << endl;
+}
 
-    int nodes_id = 0;
-    map<shared_ptr<CCSProcess>, int, PtrCmp<CCSProcess>> nodes;
-    set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>> frontier;
-    
-    shared_ptr<CCSProcess> start = program.getProcess();
-    nodes[start] = nodes_id++;
-    frontier.insert(start);
-    cout << "    start [shape=point];" << endl;
-    cout << "    start -> p0;" << endl;
+void GraphAnalysis::state(const CCSExplorer::State& s)
+{
+    if(!s.error)
+        printNode(s.id, *s.process, false, true, s.trans.empty());
+}
 
-    int depth = 0;
-    while((opt_max_depth < 0 || depth < opt_max_depth) && !frontier.empty())
-    {
-        set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>> frontier2;
-        for(shared_ptr<CCSProcess> p : frontier)
-        {
-            int id = nodes[p];
-            set<CCSTransition> trans;
-            try
-            {
-                trans = p->getTransitions(program, !opt_no_fold);
-                printNode(id, *p, false, true, trans.empty());
-            }
-            catch(CCSException& ex)
-            {
-                if(opt_ignore_error)
-                {
-                    cerr << "warning: " << ex.what() << endl;
-                    printNode(id, *p, true, true, false);
-                }
-                else
-                {
-                    cerr << "error: " << ex.what() << endl;
-                    return 1;
-                }
-            }
+void GraphAnalysis::transition(const CCSExplorer::State& s, size_t i)
+{ out << "    p" << s.id << " -> p" << s.targets[i] << " [label=" << quoted((string)s.trans[i].getAction()) << "];" << endl; }
 
-            for(CCSTransition t : trans)
-            {
-                shared_ptr<CCSProcess> p2 = t.getTo();
-                int id2;
-                if(nodes.count(p2))
-                    id2 = nodes[p2];
-                else
-                {
-                    id2 = nodes_id++;
-                    nodes[p2] = id2;
-                    frontier2.insert(p2);
-                }
+bool GraphAnalysis::error(const CCSExplorer::State& s)
+{
+    printNode(s.id, *s.process, true, true, false);
+    return true;
+}
 
-                cout << "    p" << id << " -> p" << id2 << " [label=" << quoted((string)t.getAction()) << "];" << endl;
-            }
-        }
+void GraphAnalysis::unexplored(size_t id, const CCSRef<CCSProcess>& p)
+{ printNode(id, *p, false, false, false); }
 
-        depth++;
-        frontier = move(frontier2);
-    }
-    for(shared_ptr<CCSProcess> p : frontier)
-        printNode(nodes[p], *p, false, false, false);
-    cout << "}" << endl;
-    return 0;
-}
+void GraphAnalysis::finished()
+{ out << "}" << endl; }
@@ -2,7 +2,27 @@
 #define CMD_GRAPH_H_INCLUDED
 
 #include "ccs++/ccs.h"
+#include "ccs++/ccsexplorer.h"
 
-int cmd_graph(ccspp::CCSProgram& program);
+#include <iostream>
+
+/** @brief Analysis writing the LTS as a graph in DOT format. */
+class GraphAnalysis : public ccspp::CCSExplorer::Observer
+{
+private:
+    std::ostream& out;
+
+    void printNode(std::size_t id, ccspp::CCSProcess& p, bool error, bool explored, bool term);
+
+public:
+    GraphAnalysis(std::ostream& out);
+
+    virtual void discovered(std::size_t id, const ccspp::CCSRef<ccspp::CCSProcess>& p, const ccspp::CCSExplorer::State* from, std::size_t i);
+    virtual void state(const ccspp::CCSExplorer::State& s);
+    virtual void transition(const ccspp::CCSExplorer::State& s, std::size_t i);
+    virtual bool error(const ccspp::CCSExplorer::State& s);
+    virtual void unexplored(std::size_t id, const ccspp::CCSRef<ccspp::CCSProcess>& p);
+    virtual void finished();
+};
 
 #endif //CMD_GRAPH_H_INCLUDED
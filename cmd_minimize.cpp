@@ -0,0 +1,51 @@
+#include "main.h"
+#include "cmd_minimize.h"
+#include "ccs++/ccsbisim.h"
+
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+using namespace ccspp;
+
+MinimizeAnalysis::MinimizeAnalysis(ostream& out)
+    :out(out), builder(lts)
+{}
+
+void MinimizeAnalysis::discovered(size_t id, const CCSRef<CCSProcess>& p, const CCSExplorer::State* from, size_t i)
+{ builder.discovered(id, p, from, i); }
+
+void MinimizeAnalysis::state(const CCSExplorer::State& s)
+{ builder.state(s); }
+
+void MinimizeAnalysis::finished()
+{
+    CCSBisimulation bisim(lts, opt_bisimulation);
+    CCSLTS min;
+    bisim.quotient(lts, min);
+    cerr << "minimize: " << lts.getStateCount() << " states and " << lts.getEdgeCount() << " transitions reduced to "
+        << min.getStateCount() << " states and " << min.getEdgeCount() << " transitions" << endl;
+
+    out << "digraph lts {" << endl;
+    out << "    start [shape=point];" << endl;
+    out << "    start -> p0;" << endl;
+    for(uint32_t b = 0; b < min.getStateCount(); b++)
+    {
+        bool explored = b < min.getExploredCount();
+        out << "    p" << b << " [";
+        if(opt_omit_names)
+            out << "label=\"\"";
+        else
+            out << "label=" << quoted((string)*min.getProcess(b));
+        if(explored && !min.isError(b) && min.beginEdges(b) == min.endEdges(b))
+            out << ",shape=box";
+        if(!explored)
+            out << ",style=dashed";
+        if(explored && min.isError(b))
+            out << ",color=red";
+        out << "];" << endl;
+        for(const CCSLTS::Edge* e = min.beginEdges(b); e != min.endEdges(b); e++)
+            out << "    p" << b << " -> p" << e->target << " [label=" << quoted((string)min.getAction(e->action)) << "];" << endl;
+    }
+    out << "}" << endl;
+}
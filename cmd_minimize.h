@@ -0,0 +1,28 @@
+#ifndef CMD_MINIMIZE_H_INCLUDED
+#define CMD_MINIMIZE_H_INCLUDED
+
+#include "ccs++/ccs.h"
+#include "ccs++/ccsexplorer.h"
+#include "ccs++/ccslts.h"
+
+#include <iostream>
+
+/** @brief Analysis building the LTS and writing its quotient modulo bisimilarity (see opt_bisimulation) as a graph in DOT format
+    (see CCSBisimulation). The nodes are labelled with the process of the first state of their block.
+*/
+class MinimizeAnalysis : public ccspp::CCSExplorer::Observer
+{
+private:
+    std::ostream& out;
+    ccspp::CCSLTS lts;
+    ccspp::CCSLTS::Builder builder;
+
+public:
+    MinimizeAnalysis(std::ostream& out);
+
+    virtual void discovered(std::size_t id, const ccspp::CCSRef<ccspp::CCSProcess>& p, const ccspp::CCSExplorer::State* from, std::size_t i);
+    virtual void state(const ccspp::CCSExplorer::State& s);
+    virtual void finished();
+};
+
+#endif //CMD_MINIMIZE_H_INCLUDED
@@ -1,9 +1,12 @@
 #include "main.h"
 #include "cmd_random.h"
+#include "cmd_explore.h"
+#include "ccs++/ccsbudget.h"
 
 #include <iostream>
 #include <memory>
 #include <random>
+#include <vector>
 
 using namespace std;
 using namespace ccspp;
@@ -13,15 +16,18 @@ int cmd_random(CCSProgram& program)
     random_device r;
     mt19937_64 rng(r());
 
-    shared_ptr<CCSProcess> p = program.getProcess();
+    CCSRef<CCSProcess> p = program.getProcess();
     cout << *p << endl;
+    vector<CCSTransition> trans;
+    CCSBudget budget(opt_max_states, (size_t)opt_max_memory << 20, opt_timeout);
     int depth = 0;
     while(opt_max_depth < 0 || depth < opt_max_depth)
     {
-        set<CCSTransition> trans;
+        if(budget.exceeded(depth + 1))
+            break;
         try
         {
-            trans = p->getTransitions(program, !opt_no_fold);
+            p->getTransitions(program, trans, !opt_no_fold);
         }
         catch(CCSException& ex)
         {
@@ -36,11 +42,11 @@ int cmd_random(CCSProgram& program)
         if(trans.empty())
             break;
         uniform_int_distribution<long> dist(0, trans.size() - 1);
-        CCSTransition t = *next(trans.begin(), dist(rng));
+        CCSTransition t = trans[dist(rng)];
         cout << "    --( " << t.getAction() << " )->" << endl;
         p = t.getTo();
         cout << *p << endl;
         depth++;
     }
-    return 0;
+    return report_budget(budget, depth + 1) ? 2 : 0;
 }
@@ -1,51 +1,129 @@
 #include "cmd_ttr.h"
 #include "main.h"
-#include <stack>
+#include "cmd_explore.h"
+#include "ccs++/ccsbudget.h"
+#include "ccs++/ccsdfs.h"
+#include <atomic>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
 #include <vector>
 
 using namespace std;
 using namespace ccspp;
 
-bool dfs_limit(CCSProgram& program, shared_ptr<CCSProcess> p, int depth, set<vector<CCSAction>>& seen,
-               set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>>& visited, deque<CCSTransition>& trace)
+//something to report, at the position of its path in a sequential depth-first search
+struct Event
 {
-    if(depth <= 0)
-        return false;
-    if(visited.count(p))
-        return true;
+    enum Kind { TRACE, WARNING, ERROR };
+
+    vector<uint32_t> order;
+    Kind kind;
+    vector<CCSTransition> trace;
+    CCSRef<CCSProcess> last;
+    string message;
+};
+
+//one iteration of the iterative deepening: searches all paths up to a depth without cycles
+class TraceVisitor : public CCSDepthFirstExplorer::Visitor
+{
+private:
+    size_t depth;
+    const set<vector<CCSAction>>& seen;
+    CCSBudget& budget;
+    atomic<size_t>& entered;
+    mutex lock;
+    //only the first path (in depth-first order) of every trace is reported
+    map<vector<CCSAction>, Event> traces;
+    vector<Event> messages;
+    bool complete;
 
-    set<CCSTransition> trans;
+public:
+    TraceVisitor(size_t depth, const set<vector<CCSAction>>& seen, CCSBudget& budget, atomic<size_t>& entered)
+        :depth(depth), seen(seen), budget(budget), entered(entered), complete(true)
+    {}
 
-    try
+    virtual bool enter(const CCSDepthFirstExplorer::Path& path, unsigned worker)
     {
-        trans = p->getTransitions(program, !opt_no_fold);
+        //once the budget is exceeded, the remaining paths on the stacks are dropped
+        if(budget.exceeded(++entered))
+            return false;
+        if(path.getLength() >= depth)
+        {
+            lock_guard<mutex> l(lock);
+            complete = false;
+            return false;
+        }
+        const CCSDepthFirstExplorer::Path* parent = path.getParent();
+        return !parent || !parent->contains(path.getProcess());
     }
-    catch(CCSException& ex)
+
+    virtual bool expand(const CCSDepthFirstExplorer::Path& path, const vector<CCSTransition>& trans, unsigned worker)
     {
-        if(opt_ignore_error)
-        {
-            cerr << "warning: " << ex.what() << endl;
+        if(!trans.empty())
             return true;
-        }
-        else
+
+        vector<CCSTransition> trace = path.getTrace();
+        vector<CCSAction> actions;
+        for(const CCSTransition& t : trace)
+            actions.push_back(t.getAction());
+        if(seen.count(actions))
+            return false;
+
+        vector<uint32_t> order = path.getOrder();
+        lock_guard<mutex> l(lock);
+        auto it = traces.find(actions);
+        if(it == traces.end())
+            traces.emplace(move(actions), Event{ move(order), Event::TRACE, move(trace), path.getProcess(), "" });
+        else if(order < it->second.order)
         {
-            cerr << "error: " << ex.what() << endl;
-            throw;
+            it->second.order = move(order);
+            it->second.trace = move(trace);
+            it->second.last = path.getProcess();
         }
+        return false;
+    }
+
+    virtual void error(const CCSDepthFirstExplorer::Path& path, const CCSException& ex, unsigned worker)
+    {
+        lock_guard<mutex> l(lock);
+        messages.push_back(Event{ path.getOrder(), opt_ignore_error ? Event::WARNING : Event::ERROR, {}, nullptr, ex.what() });
     }
 
-    if(trans.empty())
+    bool isComplete() const
+    { return complete; }
+
+    //reports the events in depth-first order, returns false if there was an error
+    bool report(set<vector<CCSAction>>& seen)
     {
-        vector<CCSAction> next;
-        for(CCSTransition t : trace)
-            next.push_back(t.getAction());
-        if(!seen.count(next))
+        vector<Event> events = move(messages);
+        for(auto& trace : traces)
+            events.push_back(move(trace.second));
+        sort(events.begin(), events.end(), [](const Event& e1, const Event& e2)
+            { return e1.order < e2.order; });
+
+        for(Event& e : events)
         {
+            if(e.kind == Event::WARNING)
+            {
+                cerr << "warning: " << e.message << endl;
+                continue;
+            }
+            else if(e.kind == Event::ERROR)
+            {
+                cerr << "error: " << e.message << endl;
+                return false;
+            }
+
+            vector<CCSAction> next;
+            for(const CCSTransition& t : e.trace)
+                next.push_back(t.getAction());
             seen.insert(next);
             if(opt_full_paths)
             {
-                cout << *trace.front().getFrom();
-                for(CCSTransition t : trace)
+                cout << *e.trace.front().getFrom();
+                for(const CCSTransition& t : e.trace)
                     cout << "   --( " << t.getAction() << " )->   " << *t.getTo();
                 cout << endl;
             }
@@ -53,51 +131,39 @@ bool dfs_limit(CCSProgram& program, shared_ptr<CCSProcess> p, int depth, set<vec
             {
                 cout << "[";
                 bool first = true;
-                for(CCSTransition t : trace)
+                for(const CCSTransition& t : e.trace)
                 {
                     if(!first)
                         cout << ", ";
                     first = false;
                     cout << t.getAction();
                 }
-                cout << "] ~> " << *p << endl;
+                cout << "] ~> " << *e.last << endl;
             }
         }
         return true;
     }
-
-    visited.insert(p);
-    bool res = true;
-    for(const CCSTransition& next : trans)
-    {
-        trace.push_back(next);
-        res &= dfs_limit(program, next.getTo(), depth - 1, seen, visited, trace);
-        trace.pop_back();
-    }
-    visited.erase(p);
-    return res;
-}
-
-bool dfs_limit(CCSProgram& program, shared_ptr<CCSProcess> p, int depth, set<vector<CCSAction>>& seen)
-{
-    set<shared_ptr<CCSProcess>, PtrCmp<CCSProcess>> visited;
-    deque<CCSTransition> trace;
-    return dfs_limit(program, p, depth, seen, visited, trace);
-}
+};
 
 int cmd_ttr(CCSProgram& program)
 {
-    try
-    {
-        int depth = 0;
-        set<vector<CCSAction>> seen;
-        while(depth <= opt_max_depth || opt_max_depth < 1)
-            if(dfs_limit(program, program.getProcess(), depth++, seen))
-                break;
-    }
-    catch(CCSException& ex)
+    CCSDepthFirstExplorer explorer(program, !opt_no_fold, opt_threads);
+    CCSBudget budget(opt_max_states, (size_t)opt_max_memory << 20, opt_timeout);
+    atomic<size_t> entered(0);
+    int depth = 0;
+    set<vector<CCSAction>> seen;
+    while(depth <= opt_max_depth || opt_max_depth < 1)
     {
-        return 1;
+        TraceVisitor visitor(depth++, seen, budget, entered);
+        explorer.explore(visitor);
+        if(!visitor.report(seen))
+            return 1;
+        //the traces found in the last iteration are reported, but it may have missed some
+        if(budget.getExceeded() != CCSBudget::NONE)
+            break;
+        if(visitor.isComplete())
+            break;
     }
-    return 0;
+    //the states are counted once per path and iteration of the deepening
+    return report_budget(budget, entered) ? 2 : 0;
 }
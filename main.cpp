@@ -1,15 +1,19 @@
 #include "ccs++/ccs.h"
 #include "ccs++/ccsparser.h"
+#include "ccs++/ccsbisim.h"
 
-#include "cmd_graph.h"
-#include "cmd_random.h"
-#include "cmd_actions.h"
+#include "cmd_explore.h"
 #include "cmd_dead.h"
+#include "cmd_random.h"
 #include "cmd_ttr.h"
 
+#include <cctype>
 #include <iostream>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <thread>
+#include <algorithm>
 #include <cli++/cli.h>
 
 using namespace std;
@@ -19,8 +23,65 @@ using namespace ccspp;
 int opt_max_depth = -1;
 bool opt_ignore_error = false;
 bool opt_no_fold = false;
+bool opt_no_product = false;
 bool opt_full_paths = false;
 bool opt_omit_names = false;
+int opt_cache_size = 0;
+unsigned opt_threads = 1;
+int opt_bitstate = 0;
+bool opt_hash_compaction = false;
+bool opt_normalize = false;
+bool opt_por = false;
+bool opt_symmetry = false;
+vector<map<uint32_t, uint32_t>> opt_permutations;
+string opt_external;
+CCSBisimulation::Equivalence opt_bisimulation = CCSBisimulation::STRONG;
+long long opt_max_states = 0;
+long long opt_max_memory = 0;
+double opt_timeout = 0;
+
+//parses a permutation of action names in cycle notation, e.g. "(a b c)(d e)"
+bool parsePermutation(const string& str, vector<vector<string>>& cycles)
+{
+    vector<string> cycle;
+    bool open = false;
+    size_t i = 0;
+    while(i < str.size())
+    {
+        char c = str[i];
+        if(c == '(' && !open)
+        {
+            open = true;
+            cycle.clear();
+            i++;
+        }
+        else if(c == ')' && open && !cycle.empty())
+        {
+            cycles.push_back(move(cycle));
+            open = false;
+            i++;
+        }
+        else if(c == ' ' || c == ',')
+            i++;
+        else if(open && (isalnum(c) || c == '_'))
+        {
+            size_t end = i;
+            while(end < str.size() && (isalnum(str[end]) || str[end] == '_'))
+                end++;
+            string name = str.substr(i, end - i);
+            if(find(cycle.begin(), cycle.end(), name) != cycle.end())
+                return false;
+            for(const vector<string>& other : cycles)
+                if(find(other.begin(), other.end(), name) != other.end())
+                    return false;
+            cycle.push_back(name);
+            i = end;
+        }
+        else
+            return false;
+    }
+    return !open && !cycles.empty();
+}
 
 void printUsage(char* argv0)
 {
@@ -42,10 +103,16 @@ void printHelp(char* argv0)
         "        Search for all actions" << endl <<
         "    dead" << endl <<
         "        Search for deadlocks (states with no outgoing transitions)" << endl <<
+        "    minimize" << endl <<
+        "        Output a graph of the LTS minimized modulo bisimilarity (see --bisimulation) in DOT format" << endl <<
+        "        (every node stands for a class of bisimilar states, labelled with one of them)" << endl <<
+        "        (not supported with --por, --permutation and --external)" << endl <<
         "    ttr" << endl <<
         "        Search for terminating traces" << endl <<
         "    echo" << endl <<
         "        Outputs the CCS program (for debugging)" << endl <<
+        "The commands graph, actions, dead and minimize can be combined with commas (e.g. \"dead,actions\")," << endl <<
+        "they are then computed in a single exploration of the LTS and output in the given order." << endl <<
         endl <<
         "options (general):" << endl <<
         "    -d, --depth" << endl <<
@@ -54,8 +121,57 @@ void printHelp(char* argv0)
         "        Ignores errors during LTS exploration" << endl <<
         "    --no-fold" << endl <<
         "        Do not fold constant expressions to constants" << endl <<
+        "    --no-product" << endl <<
+        "        Explore the terms of the processes instead of the product of their sequential components" << endl <<
+        "        (the product is only explored with one thread and without --normalize, so -t with more than one thread" << endl <<
+        "        and --normalize imply --no-product)" << endl <<
         "    --full-paths" << endl <<
         "        Show full paths instead traces (including all states)" << endl <<
+        "    -c, --cache <entries>" << endl <<
+        "        Caches the transitions of up to <entries> subprocesses (0 disables the cache)" << endl <<
+        "    -t, --threads <n>" << endl <<
+        "        Explores with <n> threads (0 uses all hardware threads, not for random); graph, actions and dead then" << endl <<
+        "        explore the terms instead of the product of the components (see --no-product), --por and --symmetry" << endl <<
+        "        and --external use one thread" << endl <<
+        "    --bitstate <bits>" << endl <<
+        "        Stores the visited states only as bits in a table of 2^<bits> bits (6 to 40, only for dead)," << endl <<
+        "        which may miss states, but needs no more memory; the estimated coverage is printed at the end" << endl <<
+        "    --hash-compaction" << endl <<
+        "        Stores the visited states only as 64 bit hashes and rebuilds the paths to deadlocks by exploring them again," << endl <<
+        "        which needs much less memory, but may miss states if two states have the same hash (very unlikely);" << endl <<
+        "        this only applies to the term explorer (--no-product, or -t with more than one thread), the product of" << endl <<
+        "        the components keeps its compact vectors of local states and only dead rebuilds its paths (without --por" << endl <<
+        "        and --symmetry); with --normalize, dead keeps the transitions of its paths instead of rebuilding them" << endl <<
+        "    --external <dir>" << endl <<
+        "        Stores the visited states in temporary files in <dir> instead of memory, removing duplicates" << endl <<
+        "        by sorting and merging (only for networks of sequential processes, not for random, ttr, minimize" << endl <<
+        "        and --bitstate); the buffers of the sorting and the files use 256 MB, or half of --max-memory if it is less" << endl <<
+        "    --normalize" << endl <<
+        "        Rewrites every state into a normal form, merging states that only differ by the order of operands of | and +," << endl <<
+        "        by 0 in choices, 1 in parallel compositions or by restrictions of actions the process cannot perform" << endl <<
+        "        (implies --no-product, so it is not supported with --por, --symmetry and --external)" << endl <<
+        "    --por" << endl <<
+        "        Explores only a part of the transitions of every state, leaving out interleavings of independent components" << endl <<
+        "        (partial order reduction, only for networks of sequential processes and graph, actions and dead);" << endl <<
+        "        all deadlocks and actions are found, but the paths may be longer and errors may be missed" << endl <<
+        "    --symmetry" << endl <<
+        "        Explores only one of the states that differ by the order of equal components of a parallel composition" << endl <<
+        "        (e.g. Inc | Inc | Lock, only for networks of sequential processes and graph, actions and dead)" << endl <<
+        "    --permutation <cycles>" << endl <<
+        "        Also explores only one of the states that are mapped to each other by renaming the actions with the given" << endl <<
+        "        permutation, e.g. \"(get1 get2 get3)(put1 put2 put3)\" for three dining philosophers (implies --symmetry," << endl <<
+        "        can be given several times); the deadlocks are found up to the symmetries, and the graph is the quotient" << endl <<
+        "        (the paths of dead are mapped back to paths of the program, also with --symmetry alone)" << endl <<
+        "    --bisimulation <strong|branching|weak>" << endl <<
+        "        The bisimilarity used by minimize (default: strong); branching and weak bisimilarity abstract from" << endl <<
+        "        the tau transitions (i), but branching bisimilarity keeps the branching structure of the visible actions" << endl <<
+        "    --max-states <n>" << endl <<
+        "    --max-memory <MB>" << endl <<
+        "    --timeout <seconds>" << endl <<
+        "        Stops the exploration when about <n> states are discovered, the process has used <MB> MB" << endl <<
+        "        or the time is up; the results found so far are output (unexplored states are dashed in graph)," << endl <<
+        "        a summary is printed and the exit code is 2 (ttr counts the states of every path it searches" << endl <<
+        "        in every round of the deepening, random counts the states of its path)" << endl <<
         "    -h, --help" << endl <<
         "        Print this help message" << endl <<
         endl <<
@@ -70,13 +186,29 @@ int main(int argc, char** argv)
     CLIOpt cli_depth = cli.addOpt('d', "depth", 1);
     CLIOpt cli_ignore_error = cli.addOpt('i', "ignore-error");
     CLIOpt cli_no_fold = cli.addOpt("no-fold");
+    CLIOpt cli_no_product = cli.addOpt("no-product");
     CLIOpt cli_full_paths = cli.addOpt("full-paths");
     CLIOpt cli_help = cli.addOpt('h', "help");
     CLIOpt cli_omit_names = cli.addOpt("omit-names");
+    CLIOpt cli_cache = cli.addOpt('c', "cache", 1);
+    CLIOpt cli_threads = cli.addOpt('t', "threads", 1);
+    CLIOpt cli_bitstate = cli.addOpt("bitstate", 1);
+    CLIOpt cli_hash_compaction = cli.addOpt("hash-compaction");
+    CLIOpt cli_external = cli.addOpt("external", 1);
+    CLIOpt cli_normalize = cli.addOpt("normalize");
+    CLIOpt cli_por = cli.addOpt("por");
+    CLIOpt cli_symmetry = cli.addOpt("symmetry");
+    CLIOpt cli_permutation = cli.addOpt("permutation", 1);
+    CLIOpt cli_bisimulation = cli.addOpt("bisimulation", 1);
+    CLIOpt cli_max_states = cli.addOpt("max-states", 1);
+    CLIOpt cli_max_memory = cli.addOpt("max-memory", 1);
+    CLIOpt cli_timeout = cli.addOpt("timeout", 1);
 
-    enum Command { NONE, GRAPH, RANDOM, ACTIONS, DEAD, TTR, ECHO };
+    enum Command { NONE, EXPLORE, RANDOM, TTR, ECHO };
 
     Command cmd = NONE;
+    vector<string> analyses;
+    vector<vector<vector<string>>> permutations;
     std::string inputfile;
 
     try
@@ -99,10 +231,136 @@ int main(int argc, char** argv)
                     return 1;
                 }
             }
+            else if(arg.opt == cli_cache)
+            {
+                try
+                {
+                    opt_cache_size = stoi(arg.params[0]);
+                }
+                catch(exception& ex)
+                {
+                    cout << "invalid number: " << arg.params[0] << endl;
+                    return 1;
+                }
+                if(opt_cache_size < 0)
+                {
+                    cout << "invalid cache size: " << arg.params[0] << endl;
+                    return 1;
+                }
+            }
+            else if(arg.opt == cli_threads)
+            {
+                int threads;
+                try
+                {
+                    threads = stoi(arg.params[0]);
+                }
+                catch(exception& ex)
+                {
+                    cout << "invalid number: " << arg.params[0] << endl;
+                    return 1;
+                }
+                if(threads < 0)
+                {
+                    cout << "invalid number of threads: " << arg.params[0] << endl;
+                    return 1;
+                }
+                opt_threads = threads == 0 ? max(thread::hardware_concurrency(), 1u) : threads;
+            }
+            else if(arg.opt == cli_bitstate)
+            {
+                try
+                {
+                    opt_bitstate = stoi(arg.params[0]);
+                }
+                catch(exception& ex)
+                {
+                    cout << "invalid number: " << arg.params[0] << endl;
+                    return 1;
+                }
+                if(opt_bitstate < 6 || opt_bitstate > 40)
+                {
+                    cout << "invalid size of the bit-state table: " << arg.params[0] << endl;
+                    return 1;
+                }
+            }
+            else if(arg.opt == cli_external)
+                opt_external = arg.params[0];
+            else if(arg.opt == cli_max_states || arg.opt == cli_max_memory)
+            {
+                long long n;
+                try
+                {
+                    n = stoll(arg.params[0]);
+                }
+                catch(exception& ex)
+                {
+                    cout << "invalid number: " << arg.params[0] << endl;
+                    return 1;
+                }
+                if(n <= 0)
+                {
+                    cout << "invalid limit: " << arg.params[0] << endl;
+                    return 1;
+                }
+                (arg.opt == cli_max_states ? opt_max_states : opt_max_memory) = n;
+            }
+            else if(arg.opt == cli_timeout)
+            {
+                try
+                {
+                    opt_timeout = stod(arg.params[0]);
+                }
+                catch(exception& ex)
+                {
+                    cout << "invalid number: " << arg.params[0] << endl;
+                    return 1;
+                }
+                if(opt_timeout <= 0)
+                {
+                    cout << "invalid timeout: " << arg.params[0] << endl;
+                    return 1;
+                }
+            }
+            else if(arg.opt == cli_bisimulation)
+            {
+                if(arg.params[0] == "strong")
+                    opt_bisimulation = CCSBisimulation::STRONG;
+                else if(arg.params[0] == "branching")
+                    opt_bisimulation = CCSBisimulation::BRANCHING;
+                else if(arg.params[0] == "weak")
+                    opt_bisimulation = CCSBisimulation::WEAK;
+                else
+                {
+                    cout << "invalid bisimulation: " << arg.params[0] << endl;
+                    return 1;
+                }
+            }
             else if(arg.opt == cli_ignore_error)
                 opt_ignore_error = true;
             else if(arg.opt == cli_no_fold)
                 opt_no_fold = true;
+            else if(arg.opt == cli_no_product)
+                opt_no_product = true;
+            else if(arg.opt == cli_hash_compaction)
+                opt_hash_compaction = true;
+            else if(arg.opt == cli_normalize)
+                opt_normalize = true;
+            else if(arg.opt == cli_por)
+                opt_por = true;
+            else if(arg.opt == cli_symmetry)
+                opt_symmetry = true;
+            else if(arg.opt == cli_permutation)
+            {
+                vector<vector<string>> cycles;
+                if(!parsePermutation(arg.params[0], cycles))
+                {
+                    cout << "invalid permutation: " << arg.params[0] << endl;
+                    return 1;
+                }
+                opt_symmetry = true;
+                permutations.push_back(move(cycles));
+            }
             else if(arg.opt == cli_full_paths)
                 opt_full_paths = true;
             else if(arg.opt == cli_omit_names)
@@ -114,14 +372,28 @@ int main(int argc, char** argv)
             }
             else if(cmd == NONE)
             {
-                if(arg.str == "graph")
-                    cmd = GRAPH;
+                if(arg.str.find(',') != string::npos || is_analysis(arg.str))
+                {
+                    //analyses separated by commas share one exploration
+                    cmd = EXPLORE;
+                    size_t begin = 0;
+                    for(;;)
+                    {
+                        size_t end = arg.str.find(',', begin);
+                        string name = arg.str.substr(begin, end == string::npos ? string::npos : end - begin);
+                        if(!is_analysis(name))
+                        {
+                            cerr << "error: not an analysis of the state space: " << name << endl;
+                            return 1;
+                        }
+                        analyses.push_back(name);
+                        if(end == string::npos)
+                            break;
+                        begin = end + 1;
+                    }
+                }
                 else if(arg.str == "random")
                     cmd = RANDOM;
-                else if(arg.str == "actions")
-                    cmd = ACTIONS;
-                else if(arg.str == "dead")
-                    cmd = DEAD;
                 else if(arg.str == "ttr")
                     cmd = TTR;
                 else if(arg.str == "echo")
@@ -178,16 +450,51 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    //the names are interned after the program, so they do not change the ids of its names
+    //(the names the program does not use are rejected by the symmetry reduction)
+    for(const vector<vector<string>>& cycles : permutations)
+    {
+        map<uint32_t, uint32_t> perm;
+        for(const vector<string>& cycle : cycles)
+            for(size_t k = 0; k < cycle.size(); k++)
+                perm[CCSSymbols::intern(cycle[k])] = CCSSymbols::intern(cycle[(k + 1) % cycle.size()]);
+        opt_permutations.push_back(move(perm));
+    }
+
+    program->setCacheSize(opt_cache_size);
+    program->setNormalize(opt_normalize);
+
+    if(opt_por && (cmd == RANDOM || cmd == TTR || opt_bitstate != 0))
+    {
+        cerr << "error: the partial order reduction is only supported by graph, actions and dead" << endl;
+        return 1;
+    }
+    if(opt_symmetry && (cmd == RANDOM || cmd == TTR || opt_bitstate != 0))
+    {
+        cerr << "error: the symmetry reduction is only supported by graph, actions and dead" << endl;
+        return 1;
+    }
+    if(!opt_external.empty() && (cmd == RANDOM || cmd == TTR || opt_bitstate != 0))
+    {
+        cerr << "error: the external mode is only supported by graph, actions and dead" << endl;
+        return 1;
+    }
+
     switch(cmd)
     {
-    case GRAPH:
-        return cmd_graph(*program);
+    case EXPLORE:
+        if(opt_bitstate != 0)
+        {
+            if(analyses != vector<string>{ "dead" })
+            {
+                cerr << "error: the bit-state mode is only supported by dead" << endl;
+                return 1;
+            }
+            return cmd_dead_bitstate(*program);
+        }
+        return cmd_explore(*program, analyses);
     case RANDOM:
         return cmd_random(*program);
-    case ACTIONS:
-        return cmd_actions(*program);
-    case DEAD:
-        return cmd_dead(*program);
     case TTR:
         return cmd_ttr(*program);
     case ECHO:
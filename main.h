@@ -1,10 +1,31 @@
 #ifndef MAIN_H_INCLUDED
 #define MAIN_H_INCLUDED
 
+#include "ccs++/ccsbisim.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
 extern int opt_max_depth;
 extern bool opt_ignore_error;
 extern bool opt_no_fold;
+extern bool opt_no_product;
 extern bool opt_full_paths;
 extern bool opt_omit_names;
+extern int opt_cache_size;
+extern unsigned opt_threads;
+extern int opt_bitstate;
+extern bool opt_hash_compaction;
+extern bool opt_normalize;
+extern bool opt_por;
+extern bool opt_symmetry;
+extern std::vector<std::map<uint32_t, uint32_t>> opt_permutations;
+extern std::string opt_external;
+extern ccspp::CCSBisimulation::Equivalence opt_bisimulation;
+extern long long opt_max_states;
+extern long long opt_max_memory;
+extern double opt_timeout;
 
 #endif //MAIN_H_INCLUDED